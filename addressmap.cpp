@@ -0,0 +1,99 @@
+#include "addressmap.h"
+
+#include <algorithm>
+
+
+AddressMap::AddressMap()
+    : _sorted(true)
+{
+}
+
+void AddressMap::clear()
+{
+    _records.clear();
+    _names.clear();
+    _nameIds.clear();
+    _sorted = true;
+}
+
+void AddressMap::reserve(int count)
+{
+    _records.reserve(count);
+}
+
+void AddressMap::append(const SymbolAddress& address)
+{
+    auto it = _nameIds.constFind(address.name);
+    quint32 name = 0;
+    if (it != _nameIds.constEnd())
+    {
+        name = it.value();
+    }
+    else
+    {
+        name = quint32(_names.size());
+        _names.append(address.name);
+        _nameIds.insert(address.name, name);
+    }
+
+    if (!_records.isEmpty() && address.rva < _records.last().rva)
+        _sorted = false;
+
+    AddressRecord record = { address.rva, address.length, name, quint16(address.kind) };
+    _records.append(record);
+}
+
+void AddressMap::build()
+{
+    if (!_sorted)
+    {
+        std::stable_sort(_records.begin(), _records.end(),
+                         [](const AddressRecord& left, const AddressRecord& right)
+                         { return left.rva < right.rva; });
+        _sorted = true;
+    }
+
+    _records.squeeze();
+    _nameIds.clear();
+}
+
+int AddressMap::find(quint32 rva) const
+{
+    auto it = std::upper_bound(_records.constBegin(), _records.constEnd(), rva,
+                               [](quint32 value, const AddressRecord& record)
+                               { return value < record.rva; });
+
+    while (it != _records.constBegin())
+    {
+        --it;
+        if (rva - it->rva < qMax(it->length, 1u))
+            return int(it - _records.constBegin());
+
+        // Zero-length records such as publics never hide an enclosing function
+        if (it->length != 0)
+            break;
+    }
+
+    return -1;
+}
+
+int AddressMap::findFunction(quint32 rva) const
+{
+    auto it = std::upper_bound(_records.constBegin(), _records.constEnd(), rva,
+                               [](quint32 value, const AddressRecord& record)
+                               { return value < record.rva; });
+
+    // Functions do not overlap, so the first one below the address decides
+    while (it != _records.constBegin())
+    {
+        --it;
+        if (it->kind != SymbolAddress::Function)
+            continue;
+
+        if (rva - it->rva < qMax(it->length, 1u))
+            return int(it - _records.constBegin());
+        break;
+    }
+
+    return -1;
+}
@@ -0,0 +1,72 @@
+#ifndef ADDRESSMAP_H
+#define ADDRESSMAP_H
+
+
+#include "symbolprovider.h"
+
+#include <QHash>
+#include <QVector>
+
+
+struct AddressRecord
+{
+    quint32 rva;
+    quint32 length;
+    quint32 name;
+    quint16 kind;
+};
+
+
+// Address-ordered records of every symbol in the image. Names are stored
+// once and referenced by id, so a record is a fixed 16 bytes.
+class AddressMap
+{
+public:
+    AddressMap();
+
+    void clear();
+    void reserve(int count);
+    void append(const SymbolAddress& address);
+    // Call once all records are appended, only sorts when they arrived out of order
+    void build();
+
+    bool isEmpty() const;
+    int count() const;
+    const AddressRecord& at(int index) const;
+    const QString& name(const AddressRecord& record) const;
+
+    // Last record starting at or below the address that also covers it, -1 if none
+    int find(quint32 rva) const;
+    // Function covering the address, publics and data inside it are passed over
+    int findFunction(quint32 rva) const;
+
+private:
+    QVector<AddressRecord> _records;
+    QVector<QString> _names;
+    QHash<QString, quint32> _nameIds;
+    bool _sorted;
+};
+
+
+inline bool AddressMap::isEmpty() const
+{
+    return _records.isEmpty();
+}
+
+inline int AddressMap::count() const
+{
+    return _records.size();
+}
+
+inline const AddressRecord& AddressMap::at(int index) const
+{
+    return _records.at(index);
+}
+
+inline const QString& AddressMap::name(const AddressRecord& record) const
+{
+    return _names.at(int(record.name));
+}
+
+
+#endif // ADDRESSMAP_H
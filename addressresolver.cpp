@@ -0,0 +1,134 @@
+#include "addressresolver.h"
+
+#include <algorithm>
+
+
+AddressResolver::AddressResolver()
+    : _provider(nullptr)
+    , _addresses(nullptr)
+    , _capacity(DefaultCapacity)
+    , _clock(0)
+    , _hits(0)
+    , _misses(0)
+{
+}
+
+void AddressResolver::setProvider(SymbolProvider* provider)
+{
+    clear();
+    _provider = provider;
+}
+
+void AddressResolver::setAddresses(const AddressMap* addresses)
+{
+    clear();
+    _addresses = addresses;
+}
+
+void AddressResolver::setCapacity(int capacity)
+{
+    _capacity = qMax(1, capacity);
+
+    while (_ranges.size() > _capacity)
+        evict();
+}
+
+void AddressResolver::clear()
+{
+    _ranges.clear();
+    _clock = 0;
+    _hits = 0;
+    _misses = 0;
+}
+
+bool AddressResolver::resolve(quint32 rva, SymbolLocation* result)
+{
+    const SymbolRange* range = findRange(rva);
+    if (!range)
+        return false;
+
+    result->rva = rva;
+    result->function = range->name;
+    result->offset = rva - range->rva;
+    result->fileName.clear();
+    result->line = 0;
+
+    auto line = std::upper_bound(range->lines.constBegin(), range->lines.constEnd(), rva,
+                                 [](quint32 value, const SymbolLine& item)
+                                 { return value < item.rva; });
+    if (line != range->lines.constBegin())
+    {
+        --line;
+        if (rva - line->rva < qMax(line->length, 1u))
+        {
+            result->fileName = line->fileName;
+            result->line = line->line;
+        }
+    }
+
+    return true;
+}
+
+const SymbolRange* AddressResolver::findRange(quint32 rva)
+{
+    // The last range starting at or below the address is the only candidate
+    auto it = _ranges.upperBound(rva);
+    if (it != _ranges.begin())
+    {
+        --it;
+        if (rva - it->range.rva < qMax(it->range.size, 1u))
+        {
+            ++_hits;
+            it->lastUse = ++_clock;
+            return &it->range;
+        }
+    }
+
+    ++_misses;
+
+    Entry entry;
+    if (!readRange(rva, &entry.range) ||
+        rva < entry.range.rva || rva - entry.range.rva >= qMax(entry.range.size, 1u))
+    {
+        return nullptr;
+    }
+
+    if (_ranges.size() >= _capacity && !_ranges.contains(entry.range.rva))
+        evict();
+
+    entry.lastUse = ++_clock;
+    return &_ranges.insert(entry.range.rva, entry)->range;
+}
+
+bool AddressResolver::readRange(quint32 rva, SymbolRange* range)
+{
+    int index = _addresses ? _addresses->findFunction(rva) : -1;
+    if (index < 0)
+        return _provider && _provider->findFunction(rva, range);
+
+    const AddressRecord& record = _addresses->at(index);
+    range->rva = record.rva;
+    range->size = record.length;
+    range->name = _addresses->name(record);
+    range->lines.clear();
+
+    // Without lines the function alone is still an answer
+    if (_provider)
+        _provider->findLines(range->rva, range->size, &range->lines);
+
+    return true;
+}
+
+void AddressResolver::evict()
+{
+    // Only runs on a miss, which already costs a provider lookup
+    auto oldest = _ranges.begin();
+    for (auto it = _ranges.begin(); it != _ranges.end(); ++it)
+    {
+        if (it->lastUse < oldest->lastUse)
+            oldest = it;
+    }
+
+    if (oldest != _ranges.end())
+        _ranges.erase(oldest);
+}
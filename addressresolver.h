@@ -0,0 +1,77 @@
+#ifndef ADDRESSRESOLVER_H
+#define ADDRESSRESOLVER_H
+
+
+#include "addressmap.h"
+#include "symbolprovider.h"
+
+#include <QMap>
+
+
+struct SymbolLocation
+{
+    quint32 rva;
+    QString function;
+    quint32 offset;
+    QString fileName;
+    quint32 line;
+};
+
+
+// Resolves addresses to function and line. Function ranges are kept in a
+// least recently used cache, so addresses inside a cached function are
+// answered without asking the provider. Ranges missing from the cache are
+// taken from the loaded address map when there is one, the provider then
+// only reads their line tables.
+class AddressResolver
+{
+public:
+    enum { DefaultCapacity = 1024 };
+
+public:
+    AddressResolver();
+
+    void setProvider(SymbolProvider* provider);
+    void setAddresses(const AddressMap* addresses);
+    void setCapacity(int capacity);
+    void clear();
+
+    bool resolve(quint32 rva, SymbolLocation* result);
+
+    qint64 hits() const;
+    qint64 misses() const;
+
+private:
+    struct Entry
+    {
+        SymbolRange range;
+        quint64 lastUse;
+    };
+
+    const SymbolRange* findRange(quint32 rva);
+    bool readRange(quint32 rva, SymbolRange* range);
+    void evict();
+
+private:
+    SymbolProvider* _provider;
+    const AddressMap* _addresses;
+    int _capacity;
+    quint64 _clock;
+    QMap<quint32, Entry> _ranges;
+    qint64 _hits;
+    qint64 _misses;
+};
+
+
+inline qint64 AddressResolver::hits() const
+{
+    return _hits;
+}
+
+inline qint64 AddressResolver::misses() const
+{
+    return _misses;
+}
+
+
+#endif // ADDRESSRESOLVER_H
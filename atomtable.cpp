@@ -0,0 +1,60 @@
+#include "atomtable.h"
+
+#include <QVarLengthArray>
+
+
+AtomTable::AtomTable()
+    : _hits(0)
+{
+}
+
+void AtomTable::clear()
+{
+    _atoms.clear();
+    _hits = 0;
+}
+
+QString AtomTable::intern(const QString& string)
+{
+    auto it = _atoms.constFind(string);
+    if (it != _atoms.constEnd())
+    {
+        ++_hits;
+        return *it;
+    }
+
+    return *_atoms.insert(string);
+}
+
+QString AtomTable::intern(const QChar* data, int size)
+{
+    if (size <= 0)
+        return QString();
+
+    auto it = _atoms.constFind(QString::fromRawData(data, size));
+    if (it != _atoms.constEnd())
+    {
+        ++_hits;
+        return *it;
+    }
+
+    return *_atoms.insert(QString(data, size));
+}
+
+QString AtomTable::internUtf8(const char* data, int size)
+{
+    if (size <= 0)
+        return QString();
+
+    // Names are almost always ASCII, widen them on the stack to avoid a temporary string
+    QVarLengthArray<QChar, 256> characters(size);
+    for (int i = 0; i < size; ++i)
+    {
+        uchar c = uchar(data[i]);
+        if (c >= 0x80)
+            return intern(QString::fromUtf8(data, size));
+        characters[i] = QLatin1Char(char(c));
+    }
+
+    return intern(characters.constData(), size);
+}
@@ -0,0 +1,42 @@
+#ifndef ATOMTABLE_H
+#define ATOMTABLE_H
+
+
+#include <QSet>
+#include <QString>
+
+
+// Hash-consed strings. Equal names share one buffer through implicit sharing,
+// so a name repeated across thousands of dock items is stored once.
+class AtomTable
+{
+public:
+    AtomTable();
+
+    void clear();
+    int count() const;
+    qint64 hits() const;
+
+    QString intern(const QString& string);
+    // Looks the characters up in place, only a new atom is copied
+    QString intern(const QChar* data, int size);
+    QString internUtf8(const char* data, int size);
+
+private:
+    QSet<QString> _atoms;
+    qint64 _hits;
+};
+
+
+inline int AtomTable::count() const
+{
+    return _atoms.size();
+}
+
+inline qint64 AtomTable::hits() const
+{
+    return _hits;
+}
+
+
+#endif // ATOMTABLE_H
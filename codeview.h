@@ -0,0 +1,262 @@
+#ifndef CODEVIEW_H
+#define CODEVIEW_H
+
+
+#include <QtEndian>
+#include <QString>
+
+
+enum CvLeafKind
+{
+    LF_MODIFIER         = 0x1001,
+    LF_POINTER          = 0x1002,
+    LF_PROCEDURE        = 0x1008,
+    LF_MFUNCTION        = 0x1009,
+    LF_ARGLIST          = 0x1201,
+    LF_FIELDLIST        = 0x1203,
+    LF_BITFIELD         = 0x1205,
+    LF_BCLASS           = 0x1400,
+    LF_VBCLASS          = 0x1401,
+    LF_IVBCLASS         = 0x1402,
+    LF_INDEX            = 0x1404,
+    LF_VFUNCTAB         = 0x1409,
+    LF_ENUMERATE        = 0x1502,
+    LF_ARRAY            = 0x1503,
+    LF_CLASS            = 0x1504,
+    LF_STRUCTURE        = 0x1505,
+    LF_UNION            = 0x1506,
+    LF_ENUM             = 0x1507,
+    LF_MEMBER           = 0x150d,
+    LF_STMEMBER         = 0x150e,
+    LF_METHOD           = 0x150f,
+    LF_NESTTYPE         = 0x1510,
+    LF_ONEMETHOD        = 0x1511,
+    LF_INTERFACE        = 0x1519,
+    LF_BUILDINFO        = 0x1603,
+    LF_SUBSTR_LIST      = 0x1604,
+    LF_STRING_ID        = 0x1605,
+
+    LF_PAD0             = 0xf0,
+
+    LF_NUMERIC          = 0x8000,
+    LF_CHAR             = 0x8000,
+    LF_SHORT            = 0x8001,
+    LF_USHORT           = 0x8002,
+    LF_LONG             = 0x8003,
+    LF_ULONG            = 0x8004,
+    LF_QUADWORD         = 0x8009,
+    LF_UQUADWORD        = 0x800a
+};
+
+enum CvSymbolKind
+{
+    S_END               = 0x0006,
+    S_OBJNAME           = 0x1101,
+    S_THUNK32           = 0x1102,
+    S_BLOCK32           = 0x1103,
+    S_LABEL32           = 0x1105,
+    S_CONSTANT          = 0x1107,
+    S_UDT               = 0x1108,
+    S_LDATA32           = 0x110c,
+    S_GDATA32           = 0x110d,
+    S_PUB32             = 0x110e,
+    S_LPROC32           = 0x110f,
+    S_GPROC32           = 0x1110,
+    S_PROCREF           = 0x1125,
+    S_DATAREF           = 0x1126,
+    S_LPROCREF          = 0x1127,
+    S_COMPILE2          = 0x1116,
+    S_SEPCODE           = 0x1132,
+    S_COMPILE3          = 0x113c,
+    S_ENVBLOCK          = 0x113d,
+    S_LPROC32_ID        = 0x1146,
+    S_GPROC32_ID        = 0x1147,
+    S_BUILDINFO         = 0x114c,
+    S_INLINESITE        = 0x114d,
+    S_INLINESITE_END    = 0x114e,
+    S_PROC_ID_END       = 0x114f,
+    S_LPROC32_DPC       = 0x1155
+};
+
+enum CvTypeProperty
+{
+    CV_PROP_FWDREF      = 0x0080,
+    CV_PROP_UNIQUENAME  = 0x0200
+};
+
+enum CvModifierAttribute
+{
+    CV_MODATTR_CONST        = 0x0001,
+    CV_MODATTR_VOLATILE     = 0x0002,
+    CV_MODATTR_UNALIGNED    = 0x0004
+};
+
+
+// Bounds-checked little-endian cursor over a CodeView record
+class CvReader
+{
+public:
+    CvReader(const uchar* data, const uchar* end);
+
+    bool atEnd() const;
+    bool isValid() const;
+    const uchar* position() const;
+    int remaining() const;
+
+    quint8 read8();
+    quint16 read16();
+    quint32 read32();
+    quint64 read64();
+    quint64 readNumeric();
+    QString readString();
+    const char* readStringData(int* size = nullptr);
+    void skip(int bytes);
+
+private:
+    bool require(int bytes);
+
+private:
+    const uchar* _data;
+    const uchar* _end;
+    bool _valid;
+};
+
+
+inline CvReader::CvReader(const uchar* data, const uchar* end)
+    : _data(data)
+    , _end(end)
+    , _valid(data && data <= end)
+{
+}
+
+inline bool CvReader::atEnd() const
+{
+    return (!_valid || _data >= _end);
+}
+
+inline bool CvReader::isValid() const
+{
+    return _valid;
+}
+
+inline const uchar* CvReader::position() const
+{
+    return _data;
+}
+
+inline int CvReader::remaining() const
+{
+    return _valid ? int(_end - _data) : 0;
+}
+
+inline bool CvReader::require(int bytes)
+{
+    if (_valid && _end - _data >= bytes)
+        return true;
+
+    _valid = false;
+    return false;
+}
+
+inline quint8 CvReader::read8()
+{
+    if (!require(1))
+        return 0;
+
+    return *_data++;
+}
+
+inline quint16 CvReader::read16()
+{
+    if (!require(2))
+        return 0;
+
+    quint16 value = qFromLittleEndian<quint16>(_data);
+    _data += 2;
+    return value;
+}
+
+inline quint32 CvReader::read32()
+{
+    if (!require(4))
+        return 0;
+
+    quint32 value = qFromLittleEndian<quint32>(_data);
+    _data += 4;
+    return value;
+}
+
+inline quint64 CvReader::read64()
+{
+    if (!require(8))
+        return 0;
+
+    quint64 value = qFromLittleEndian<quint64>(_data);
+    _data += 8;
+    return value;
+}
+
+inline quint64 CvReader::readNumeric()
+{
+    quint16 leaf = read16();
+    if (leaf < LF_NUMERIC)
+        return leaf;
+
+    switch (leaf)
+    {
+    case LF_CHAR:
+        return quint64(qint64(qint8(read8())));
+    case LF_SHORT:
+        return quint64(qint64(qint16(read16())));
+    case LF_USHORT:
+        return read16();
+    case LF_LONG:
+        return quint64(qint64(qint32(read32())));
+    case LF_ULONG:
+        return read32();
+    case LF_QUADWORD:
+    case LF_UQUADWORD:
+        return read64();
+    default:
+        _valid = false;
+        return 0;
+    }
+}
+
+inline const char* CvReader::readStringData(int* size)
+{
+    if (!_valid)
+        return nullptr;
+
+    const uchar* start = _data;
+    while (_data < _end && *_data)
+        ++_data;
+
+    if (_data >= _end)
+    {
+        _valid = false;
+        return nullptr;
+    }
+
+    if (size)
+        *size = int(_data - start);
+
+    ++_data;
+    return reinterpret_cast<const char*>(start);
+}
+
+inline QString CvReader::readString()
+{
+    int size = 0;
+    const char* string = readStringData(&size);
+    return string ? QString::fromUtf8(string, size) : QString();
+}
+
+inline void CvReader::skip(int bytes)
+{
+    if (require(bytes))
+        _data += bytes;
+}
+
+
+#endif // CODEVIEW_H
@@ -0,0 +1,74 @@
+#include "contributionindex.h"
+
+#include <algorithm>
+
+
+ContributionIndex::ContributionIndex()
+{
+}
+
+void ContributionIndex::clear()
+{
+    _starts.clear();
+    _contributions.clear();
+    _totals.clear();
+}
+
+void ContributionIndex::reserve(int count)
+{
+    _contributions.reserve(count);
+}
+
+void ContributionIndex::add(quint32 rva, quint32 size, quint32 compiland, quint32 characteristics)
+{
+    if (size == 0)
+        return;
+
+    Contribution contribution = { rva, size, compiland, characteristics };
+    _contributions.append(contribution);
+}
+
+void ContributionIndex::build()
+{
+    std::sort(_contributions.begin(), _contributions.end(),
+              [](const Contribution& left, const Contribution& right)
+              { return left.rva < right.rva; });
+
+    // Starts are kept apart so the binary search only touches one dense array
+    _starts.resize(_contributions.size());
+    _totals.clear();
+
+    for (int i = 0; i < _contributions.size(); ++i)
+    {
+        const Contribution& contribution = _contributions.at(i);
+        _starts[i] = contribution.rva;
+
+        Totals& totals = _totals[contribution.compiland];
+        if (isCode(contribution.characteristics))
+            totals.code += contribution.size;
+        else
+            totals.data += contribution.size;
+    }
+
+    _contributions.squeeze();
+}
+
+int ContributionIndex::find(quint32 rva) const
+{
+    auto it = std::upper_bound(_starts.constBegin(), _starts.constEnd(), rva);
+    if (it == _starts.constBegin())
+        return -1;
+
+    int index = int(it - _starts.constBegin()) - 1;
+    const Contribution& contribution = _contributions.at(index);
+    if (rva - contribution.rva >= contribution.size)
+        return -1;
+
+    return index;
+}
+
+ContributionIndex::Totals ContributionIndex::totals(quint32 compiland) const
+{
+    Totals empty = { 0, 0 };
+    return _totals.value(compiland, empty);
+}
@@ -0,0 +1,81 @@
+#ifndef CONTRIBUTIONINDEX_H
+#define CONTRIBUTIONINDEX_H
+
+
+#include <QHash>
+#include <QVector>
+
+
+struct Contribution
+{
+    quint32 rva;
+    quint32 size;
+    quint32 compiland;
+    quint32 characteristics;
+};
+
+
+// Sorted address intervals of the image, each owned by one compiland
+class ContributionIndex
+{
+public:
+    enum Characteristics
+    {
+        Code                = 0x00000020,
+        InitializedData     = 0x00000040,
+        UninitializedData   = 0x00000080,
+        Execute             = 0x20000000
+    };
+
+    struct Totals
+    {
+        quint64 code;
+        quint64 data;
+    };
+
+public:
+    ContributionIndex();
+
+    void clear();
+    void reserve(int count);
+    void add(quint32 rva, quint32 size, quint32 compiland, quint32 characteristics);
+    void build();
+
+    bool isEmpty() const;
+    int count() const;
+    const Contribution& at(int index) const;
+
+    int find(quint32 rva) const;
+    Totals totals(quint32 compiland) const;
+
+    static bool isCode(quint32 characteristics);
+
+private:
+    QVector<quint32> _starts;
+    QVector<Contribution> _contributions;
+    QHash<quint32, Totals> _totals;
+};
+
+
+inline bool ContributionIndex::isEmpty() const
+{
+    return _contributions.isEmpty();
+}
+
+inline int ContributionIndex::count() const
+{
+    return _contributions.size();
+}
+
+inline const Contribution& ContributionIndex::at(int index) const
+{
+    return _contributions.at(index);
+}
+
+inline bool ContributionIndex::isCode(quint32 characteristics)
+{
+    return (characteristics & (Code | Execute)) != 0;
+}
+
+
+#endif // CONTRIBUTIONINDEX_H
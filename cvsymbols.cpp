@@ -0,0 +1,175 @@
+#include "cvsymbols.h"
+
+#include "codeview.h"
+
+
+CvSymbolIterator::CvSymbolIterator()
+    : _begin(0)
+    , _end(0)
+    , _offset(0)
+    , _valid(false)
+{
+}
+
+CvSymbolIterator::CvSymbolIterator(const QByteArray& stream, quint32 begin, quint32 end)
+    : _stream(stream)
+    , _begin(begin)
+    , _end(qMin(end, quint32(stream.size())))
+    , _offset(begin)
+    , _valid(begin <= _end)
+{
+}
+
+bool CvSymbolIterator::next(CvSymbol* symbol)
+{
+    if (!_valid || _offset + 4 > _end)
+        return false;
+
+    const uchar* data = reinterpret_cast<const uchar*>(_stream.constData()) + _offset;
+    quint16 length = qFromLittleEndian<quint16>(data);
+
+    if (length < 2 || _offset + 2 + length > _end)
+    {
+        _valid = false;
+        return false;
+    }
+
+    symbol->kind = qFromLittleEndian<quint16>(data + 2);
+    symbol->length = length - 2;
+    symbol->offset = _offset;
+    symbol->data = data + 4;
+
+    _offset += 2 + length;
+    return true;
+}
+
+bool CvSymbolIterator::skipScope(const CvSymbol& symbol)
+{
+    if (!opensScope(symbol.kind) || symbol.length < 8)
+        return false;
+
+    // Every scope record starts with pParent and pEnd, pEnd is the offset of the closing record
+    quint32 end = qFromLittleEndian<quint32>(symbol.data + 4);
+    if (end <= symbol.offset || !seek(end))
+        return false;
+
+    CvSymbol closing;
+    if (!next(&closing) || !closesScope(closing.kind))
+    {
+        _valid = false;
+        return false;
+    }
+
+    return true;
+}
+
+bool CvSymbolIterator::seek(quint32 offset)
+{
+    if (offset < _begin || offset > _end)
+    {
+        _valid = false;
+        return false;
+    }
+
+    _offset = offset;
+    return true;
+}
+
+bool CvSymbolIterator::opensScope(quint16 kind)
+{
+    switch (kind)
+    {
+    case S_GPROC32:
+    case S_LPROC32:
+    case S_GPROC32_ID:
+    case S_LPROC32_ID:
+    case S_LPROC32_DPC:
+    case S_THUNK32:
+    case S_BLOCK32:
+    case S_SEPCODE:
+    case S_INLINESITE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool CvSymbolIterator::closesScope(quint16 kind)
+{
+    return (kind == S_END || kind == S_PROC_ID_END || kind == S_INLINESITE_END);
+}
+
+bool CvSymbolIterator::isProcedure(quint16 kind)
+{
+    switch (kind)
+    {
+    case S_GPROC32:
+    case S_LPROC32:
+    case S_GPROC32_ID:
+    case S_LPROC32_ID:
+    case S_LPROC32_DPC:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool CvSymbolIterator::readProcedure(const CvSymbol& symbol, CvProcedure* procedure)
+{
+    if (!isProcedure(symbol.kind))
+        return false;
+
+    CvReader reader(symbol.data, symbol.end());
+    procedure->parent = reader.read32();
+    procedure->end = reader.read32();
+    procedure->next = reader.read32();
+    procedure->length = reader.read32();
+    reader.skip(4 + 4);
+    procedure->typeIndex = reader.read32();
+    procedure->offset = reader.read32();
+    procedure->segment = reader.read16();
+    procedure->flags = reader.read8();
+    procedure->name = reader.readStringData(&procedure->nameSize);
+
+    return reader.isValid();
+}
+
+const char* CvSymbolIterator::readName(const CvSymbol& symbol, int* size)
+{
+    CvReader reader(symbol.data, symbol.end());
+
+    switch (symbol.kind)
+    {
+    case S_PUB32:
+    case S_PROCREF:
+    case S_LPROCREF:
+    case S_DATAREF:
+    case S_GDATA32:
+    case S_LDATA32:
+        reader.skip(4 + 4 + 2);
+        break;
+    case S_UDT:
+    case S_OBJNAME:
+        reader.skip(4);
+        break;
+    case S_CONSTANT:
+        reader.skip(4);
+        reader.readNumeric();
+        break;
+    case S_LABEL32:
+        reader.skip(4 + 2 + 1);
+        break;
+    case S_THUNK32:
+        reader.skip(4 + 4 + 4 + 4 + 2 + 2 + 1);
+        break;
+    default:
+        if (isProcedure(symbol.kind))
+        {
+            reader.skip(4 * 8 + 2 + 1);
+            break;
+        }
+        return nullptr;
+    }
+
+    return reader.readStringData(size);
+}
@@ -0,0 +1,77 @@
+#ifndef CVSYMBOLS_H
+#define CVSYMBOLS_H
+
+
+#include <QByteArray>
+#include <QString>
+
+
+struct CvSymbol
+{
+    quint16 kind;
+    quint16 length;
+    quint32 offset;
+    const uchar* data;
+
+    const uchar* end() const { return data + length; }
+};
+
+struct CvProcedure
+{
+    quint32 parent;
+    quint32 end;
+    quint32 next;
+    quint32 length;
+    quint32 typeIndex;
+    quint32 offset;
+    quint16 segment;
+    quint8 flags;
+    const char* name;
+    int nameSize;
+};
+
+
+// Walks a CodeView symbol substream without copying, records point into the stream
+class CvSymbolIterator
+{
+public:
+    enum { ModuleSignatureSize = 4 };
+
+public:
+    CvSymbolIterator();
+    CvSymbolIterator(const QByteArray& stream, quint32 begin, quint32 end);
+
+    bool next(CvSymbol* symbol);
+    bool skipScope(const CvSymbol& symbol);
+    bool seek(quint32 offset);
+
+    quint32 offset() const;
+    bool isValid() const;
+
+    static bool opensScope(quint16 kind);
+    static bool closesScope(quint16 kind);
+    static bool isProcedure(quint16 kind);
+    static bool readProcedure(const CvSymbol& symbol, CvProcedure* procedure);
+    static const char* readName(const CvSymbol& symbol, int* size);
+
+private:
+    QByteArray _stream;
+    quint32 _begin;
+    quint32 _end;
+    quint32 _offset;
+    bool _valid;
+};
+
+
+inline quint32 CvSymbolIterator::offset() const
+{
+    return _offset;
+}
+
+inline bool CvSymbolIterator::isValid() const
+{
+    return _valid;
+}
+
+
+#endif // CVSYMBOLS_H
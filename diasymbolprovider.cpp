@@ -0,0 +1,474 @@
+#include "diasymbolprovider.h"
+
+#include <QFileInfo>
+
+#include <algorithm>
+
+
+// Follows DIA's search for an image's PDB. An image only reaches DIA when
+// SymbolStore::locate() found no matching PDB beside it, at its recorded
+// path or in a store, the rest of the search path is probed unless a recent
+// search for the same PDB already failed.
+class LoadCallback : public IDiaLoadCallback2
+{
+public:
+    LoadCallback(bool probing)
+        : _probing(probing)
+    {
+    }
+
+    const QString& pdbFileName() const
+    {
+        return _pdbFileName;
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override
+    {
+        if (riid == __uuidof(IUnknown) || riid == __uuidof(IDiaLoadCallback) ||
+            riid == __uuidof(IDiaLoadCallback2))
+        {
+            *object = this;
+            return S_OK;
+        }
+
+        *object = NULL;
+        return E_NOINTERFACE;
+    }
+
+    // Lives on the stack for the duration of the load
+    ULONG STDMETHODCALLTYPE AddRef() override { return 2; }
+    ULONG STDMETHODCALLTYPE Release() override { return 1; }
+
+    HRESULT STDMETHODCALLTYPE NotifyDebugDir(BOOL, DWORD, BYTE*) override { return S_OK; }
+    HRESULT STDMETHODCALLTYPE NotifyOpenDBG(LPCOLESTR, HRESULT) override { return S_OK; }
+
+    HRESULT STDMETHODCALLTYPE NotifyOpenPDB(LPCOLESTR fileName, HRESULT result) override
+    {
+        if (SUCCEEDED(result) && fileName)
+            _pdbFileName = QString::fromWCharArray(fileName);
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE RestrictRegistryAccess() override { return allowProbe(); }
+    HRESULT STDMETHODCALLTYPE RestrictSymbolServerAccess() override { return allowProbe(); }
+    HRESULT STDMETHODCALLTYPE RestrictOriginalPathAccess() override { return allowProbe(); }
+    HRESULT STDMETHODCALLTYPE RestrictReferencePathAccess() override { return allowProbe(); }
+    HRESULT STDMETHODCALLTYPE RestrictDBGAccess() override { return allowProbe(); }
+    HRESULT STDMETHODCALLTYPE RestrictSystemRootAccess() override { return allowProbe(); }
+
+private:
+    HRESULT allowProbe() const
+    {
+        return _probing ? S_OK : E_FAIL;
+    }
+
+private:
+    bool _probing;
+    QString _pdbFileName;
+};
+
+
+DiaSymbolProvider::DiaSymbolProvider()
+    : _library(NULL)
+    , _diaDataSource(NULL)
+    , _diaSession(NULL)
+    , _diaSymbolGlobal(NULL)
+    , _probing(true)
+{
+}
+
+DiaSymbolProvider::~DiaSymbolProvider()
+{
+    close();
+}
+
+bool DiaSymbolProvider::open(const QString& fileName)
+{
+    close();
+
+    _library = LoadLibraryW(L"msdia140.dll");
+    if (!_library)
+        return false;
+
+    HRESULT (WINAPI *GetClassObject)(REFCLSID rclsid, REFIID riid, LPVOID* ppv);
+
+    *((FARPROC*) &GetClassObject) = GetProcAddress(_library, "DllGetClassObject");
+    if (!GetClassObject)
+    {
+        close();
+        return false;
+    }
+
+    IClassFactory* factory = nullptr;
+    HRESULT result = GetClassObject(__uuidof(DiaSource), IID_IClassFactory, (LPVOID*) &factory);
+    if (FAILED(result))
+    {
+        close();
+        return false;
+    }
+
+    result = factory->CreateInstance(NULL, __uuidof(IDiaDataSource), (void**) &_diaDataSource);
+    factory->Release();
+
+    if (SUCCEEDED(result))
+    {
+        if (QFileInfo(fileName).suffix().compare("exe", Qt::CaseInsensitive) == 0)
+        {
+            // DIA's default search path is only used while probing is allowed
+            LoadCallback callback(_probing);
+            result = _diaDataSource->loadDataForExe((wchar_t*) fileName.utf16(),
+                                                    _probing ? NULL : L"", &callback);
+            _pdbFileName = callback.pdbFileName();
+        }
+        else
+        {
+            result = _diaDataSource->loadDataFromPdb((wchar_t*) fileName.utf16());
+            _pdbFileName = fileName;
+        }
+    }
+
+    if (SUCCEEDED(result))
+        result = _diaDataSource->openSession(&_diaSession);
+
+    if (SUCCEEDED(result))
+        result = _diaSession->get_globalScope(&_diaSymbolGlobal);
+
+    if (FAILED(result))
+    {
+        close();
+        return false;
+    }
+
+    QDIA::setResidencyLimit(ResidencyLimit);
+    QDIA::resetResidencyPeak();
+    QDIA::resetPropertyReads();
+    QDIA::setAtomTable(&_atoms);
+    return true;
+}
+
+void DiaSymbolProvider::close()
+{
+    if (_diaSymbolGlobal)
+    {
+        _diaSymbolGlobal->Release();
+        _diaSymbolGlobal = NULL;
+    }
+    if (_diaSession)
+    {
+        _diaSession->Release();
+        _diaSession = NULL;
+    }
+    if (_diaDataSource)
+    {
+        _diaDataSource->Release();
+        _diaDataSource = NULL;
+    }
+    if (_library)
+    {
+        FreeLibrary(_library);
+        _library = NULL;
+    }
+
+    _pdbFileName.clear();
+    _sourceFileNames.clear();
+    _typeNames.clear();
+
+    QDIA::setAtomTable(nullptr);
+    _atoms.clear();
+}
+
+QVector<SymbolCompiland> DiaSymbolProvider::compilands()
+{
+    QVector<SymbolCompiland> result;
+
+    QDIA::forEachChild(_diaSymbolGlobal, SymTagCompiland, [&result](IDiaSymbol* symbol)
+    {
+        QDIA::Snapshot properties = QDIA::snapshot<QDIA::PropertyIndexId | QDIA::PropertyName |
+                                                   QDIA::PropertyLibraryName>(symbol);
+
+        SymbolCompiland compiland;
+        compiland.id = properties.symIndexId;
+        compiland.name = properties.name;
+        compiland.libraryName = properties.libraryName;
+        compiland.objectPath = QDIA::getEnvPath(symbol);
+        result.append(compiland);
+        return true;
+    });
+
+    return result;
+}
+
+QVector<SymbolSourceFile> DiaSymbolProvider::sourceFiles(quint32 compiland)
+{
+    QVector<SymbolSourceFile> result;
+
+    QDiaPtr<IDiaSymbol> symbol = symbolById(compiland);
+
+    QDIA::forEachSourceFile(_diaSession, symbol, [this, &result](IDiaSourceFile* sourceFile)
+    {
+        SymbolSourceFile file;
+        DWORD uniqueId = 0;
+        file.fileName = sourceFileName(sourceFile, &uniqueId);
+        file.id = uniqueId;
+        result.append(file);
+        return true;
+    });
+
+    return result;
+}
+
+bool DiaSymbolProvider::visitTypedefs(quint32 scope, const Visitor<SymbolTypedef>& visitor)
+{
+    QDiaPtr<IDiaSymbol> parent = (scope == GlobalScope) ? QDiaPtr<IDiaSymbol>::share(_diaSymbolGlobal)
+                                                         : symbolById(scope);
+
+    DWORD compareFlags = nsNone;
+    QString name = searchName(&compareFlags);
+
+    return QDIA::forEachChild(parent, SymTagTypedef, [this, &visitor](IDiaSymbol* symbol)
+    {
+        if (!acceptsName(symbol))
+            return !isCancelled();
+
+        QDIA::Snapshot properties = QDIA::snapshot<QDIA::PropertyName | QDIA::PropertyType>(symbol, &_typeNames);
+
+        SymbolTypedef item = { properties.name, properties.type };
+        return !isCancelled() && visitor(item);
+    }, name, compareFlags);
+}
+
+bool DiaSymbolProvider::visitEnums(const Visitor<SymbolEnum>& visitor)
+{
+    DWORD compareFlags = nsNone;
+    QString name = searchName(&compareFlags);
+
+    return QDIA::forEachChild(_diaSymbolGlobal, SymTagEnum, [this, &visitor](IDiaSymbol* symbol)
+    {
+        if (!acceptsName(symbol))
+            return !isCancelled();
+
+        QDIA::Snapshot properties = QDIA::snapshot<QDIA::PropertyName | QDIA::PropertyType>(symbol, &_typeNames);
+
+        SymbolEnum item;
+        item.name = properties.name;
+        item.type = properties.type;
+        item.values = readMembers(symbol, false);
+        return !isCancelled() && visitor(item);
+    }, name, compareFlags);
+}
+
+bool DiaSymbolProvider::visitUserTypes(const Visitor<SymbolUserType>& visitor)
+{
+    DWORD compareFlags = nsNone;
+    QString name = searchName(&compareFlags);
+
+    return QDIA::forEachChild(_diaSymbolGlobal, SymTagUDT, [this, &visitor](IDiaSymbol* symbol)
+    {
+        if (!acceptsName(symbol))
+            return !isCancelled();
+
+        QDIA::Snapshot properties = QDIA::snapshot<QDIA::PropertyUdtKind | QDIA::PropertyName |
+                                                   QDIA::PropertyType>(symbol, &_typeNames);
+
+        SymbolUserType item;
+        item.kind = properties.udtKind;
+        item.name = properties.name;
+        item.type = properties.type;
+        item.members = readMembers(symbol, true);
+        return !isCancelled() && visitor(item);
+    }, name, compareFlags);
+}
+
+bool DiaSymbolProvider::visitFunctions(quint32 compiland, const Visitor<SymbolFunction>& visitor)
+{
+    QDiaPtr<IDiaSymbol> parent = symbolById(compiland);
+
+    DWORD compareFlags = nsNone;
+    QString name = searchName(&compareFlags);
+
+    return QDIA::forEachChild(parent, SymTagFunction, [this, &visitor](IDiaSymbol* symbol)
+    {
+        if (!acceptsName(symbol))
+            return !isCancelled();
+
+        QDIA::Snapshot properties = QDIA::snapshot<QDIA::PropertyUndName | QDIA::PropertyRva>(symbol);
+
+        SymbolFunction function;
+        function.name = properties.undName;
+        function.rva = properties.rva;
+        return !isCancelled() && visitor(function);
+    }, name, compareFlags);
+}
+
+bool DiaSymbolProvider::sectionContributions(ContributionIndex* index)
+{
+    return QDIA::getSectionContributions(_diaSession, index);
+}
+
+bool DiaSymbolProvider::findFunction(quint32 rva, SymbolRange* result)
+{
+    QDiaPtr<IDiaSymbol> function = QDIA::findFunction(_diaSession, rva);
+    if (!function)
+        return false;
+
+    QDIA::Snapshot properties = QDIA::snapshot<QDIA::PropertyUndName | QDIA::PropertyRva>(function);
+
+    ULONGLONG length = 0;
+    function->get_length(&length);
+
+    result->rva = properties.rva;
+    result->size = quint32(length);
+    result->name = properties.undName;
+
+    return findLines(result->rva, result->size, &result->lines);
+}
+
+bool DiaSymbolProvider::findLines(quint32 rva, quint32 size, QVector<SymbolLine>* lines)
+{
+    lines->clear();
+
+    // The whole line table of the function is read so that nearby addresses need no further calls
+    QDIA::forEachLine(_diaSession, rva, size, [this, lines](IDiaLineNumber* number)
+    {
+        SymbolLine line = { 0, 0, 0 };
+        DWORD value = 0;
+
+        number->get_relativeVirtualAddress(&value);
+        line.rva = value;
+        number->get_length(&value);
+        line.length = value;
+        number->get_lineNumber(&value);
+        line.line = value;
+
+        CComPtr<IDiaSourceFile> sourceFile;
+        if (SUCCEEDED(number->get_sourceFile(&sourceFile)) && sourceFile)
+        {
+            DWORD uniqueId = 0;
+            line.fileName = sourceFileName(sourceFile, &uniqueId);
+        }
+
+        lines->append(line);
+        return true;
+    });
+
+    std::sort(lines->begin(), lines->end(),
+              [](const SymbolLine& left, const SymbolLine& right) { return left.rva < right.rva; });
+    return true;
+}
+
+bool DiaSymbolProvider::visitAddresses(const Visitor<SymbolAddress>& visitor)
+{
+    return QDIA::forEachSymbolByAddress(_diaSession, [this, &visitor](IDiaSymbol* symbol)
+    {
+        QDIA::Snapshot properties = QDIA::snapshot<QDIA::PropertyTag | QDIA::PropertyRva |
+                                                   QDIA::PropertyLength | QDIA::PropertyUndName>(symbol);
+
+        SymbolAddress address;
+        address.rva = properties.rva;
+        address.length = quint32(properties.length);
+        address.name = properties.undName;
+
+        // The address map cannot be searched by name, every filter is checked here against
+        // the plain name, as findChildren() does, since undecorated names carry signatures
+        if (!filter().isEmpty() && !filter().matches(QDIA::snapshot<QDIA::PropertyName>(symbol).name))
+            return !isCancelled();
+
+        switch (properties.tag)
+        {
+        case SymTagFunction:
+            address.kind = SymbolAddress::Function;
+            break;
+        case SymTagData:
+            address.kind = SymbolAddress::Data;
+            break;
+        case SymTagPublicSymbol:
+            address.kind = SymbolAddress::Public;
+            break;
+        case SymTagThunk:
+            address.kind = SymbolAddress::Thunk;
+            break;
+        case SymTagLabel:
+            address.kind = SymbolAddress::Label;
+            break;
+        default:
+            address.kind = SymbolAddress::Other;
+            break;
+        }
+
+        return !isCancelled() && visitor(address);
+    });
+}
+
+QString DiaSymbolProvider::statistics() const
+{
+    QDIA::Residency residency = QDIA::residency();
+    return QStringLiteral("DIA objects: %1 live, %2 peak, %3 fetched, %4 property reads, %5 names, %6 reused")
+           .arg(residency.live).arg(residency.peak).arg(residency.fetched).arg(QDIA::propertyReads())
+           .arg(_atoms.count()).arg(_atoms.hits());
+}
+
+QDiaPtr<IDiaSymbol> DiaSymbolProvider::symbolById(quint32 id) const
+{
+    return QDIA::getSymbolById(_diaSession, id);
+}
+
+QString DiaSymbolProvider::sourceFileName(IDiaSourceFile* sourceFile, DWORD* uniqueId)
+{
+    DWORD id = QDIA::getUniqueId(sourceFile);
+    *uniqueId = id;
+
+    auto it = _sourceFileNames.constFind(id);
+    if (it != _sourceFileNames.constEnd())
+        return it.value();
+
+    return _sourceFileNames.insert(id, QDIA::getFileName(sourceFile)).value();
+}
+
+QVector<SymbolMember> DiaSymbolProvider::readMembers(IDiaSymbol* parent, bool withType)
+{
+    QVector<SymbolMember> result;
+
+    QDIA::forEachChild(parent, SymTagData, [this, &result, withType](IDiaSymbol* entity)
+    {
+        QDIA::Snapshot properties = withType
+            ? QDIA::snapshot<QDIA::PropertyName | QDIA::PropertyType | QDIA::PropertyValue>(entity, &_typeNames)
+            : QDIA::snapshot<QDIA::PropertyName | QDIA::PropertyValue>(entity);
+
+        SymbolMember member;
+        member.name = properties.name;
+        member.type = properties.type;
+        member.value = properties.value.toString();
+        result.append(member);
+        return true;
+    });
+
+    return result;
+}
+
+QString DiaSymbolProvider::searchName(DWORD* compareFlags) const
+{
+    const SymbolFilter& filter = this->filter();
+    bool caseInsensitive = (filter.caseSensitivity() == Qt::CaseInsensitive);
+
+    switch (filter.syntax())
+    {
+    case SymbolFilter::FixedString:
+        *compareFlags = caseInsensitive ? nsfCaseInsensitive : nsfCaseSensitive;
+        return filter.pattern();
+    case SymbolFilter::Wildcard:
+        // DIA's "regular expressions" are * and ? wildcards
+        *compareFlags = caseInsensitive ? nsCaseInRegularExpression : nsRegularExpression;
+        return filter.pattern();
+    default:
+        *compareFlags = nsNone;
+        return QString();
+    }
+}
+
+bool DiaSymbolProvider::acceptsName(IDiaSymbol* symbol) const
+{
+    if (filter().isEmpty() || filter().syntax() != SymbolFilter::RegularExpression)
+        return true;
+
+    return filter().matches(QDIA::snapshot<QDIA::PropertyName>(symbol).name);
+}
@@ -0,0 +1,75 @@
+#ifndef DIASYMBOLPROVIDER_H
+#define DIASYMBOLPROVIDER_H
+
+
+#include "atomtable.h"
+#include "qdia.h"
+#include "symbolprovider.h"
+
+#include <QHash>
+
+
+// Loads symbols through msdia140.dll, compiland ids are DIA symbol index ids
+class DiaSymbolProvider : public SymbolProvider
+{
+public:
+    // Upper bound on DIA objects held at once while loading
+    enum { ResidencyLimit = 1024 };
+
+public:
+    DiaSymbolProvider();
+    ~DiaSymbolProvider();
+
+    bool open(const QString& fileName) override;
+    void close() override;
+
+    // Whether opening an image may search beyond the paths already checked by the caller
+    void setProbing(bool probing);
+    // PDB actually loaded, as reported by DIA's search for an image
+    const QString& pdbFileName() const;
+
+    QVector<SymbolCompiland> compilands() override;
+    QVector<SymbolSourceFile> sourceFiles(quint32 compiland) override;
+    bool visitTypedefs(quint32 scope, const Visitor<SymbolTypedef>& visitor) override;
+    bool visitEnums(const Visitor<SymbolEnum>& visitor) override;
+    bool visitUserTypes(const Visitor<SymbolUserType>& visitor) override;
+    bool visitFunctions(quint32 compiland, const Visitor<SymbolFunction>& visitor) override;
+    bool sectionContributions(ContributionIndex* index) override;
+    bool findFunction(quint32 rva, SymbolRange* result) override;
+    bool findLines(quint32 rva, quint32 size, QVector<SymbolLine>* lines) override;
+    bool visitAddresses(const Visitor<SymbolAddress>& visitor) override;
+    QString statistics() const override;
+
+private:
+    QDiaPtr<IDiaSymbol> symbolById(quint32 id) const;
+    QString sourceFileName(IDiaSourceFile* sourceFile, DWORD* uniqueId);
+    QVector<SymbolMember> readMembers(IDiaSymbol* parent, bool withType);
+    // Pattern and compare flags handed to findChildren, empty when DIA cannot evaluate the filter
+    QString searchName(DWORD* compareFlags) const;
+    bool acceptsName(IDiaSymbol* symbol) const;
+
+private:
+    HMODULE _library;
+    IDiaDataSource* _diaDataSource;
+    IDiaSession* _diaSession;
+    IDiaSymbol* _diaSymbolGlobal;
+    bool _probing;
+    QString _pdbFileName;
+    QHash<DWORD, QString> _sourceFileNames;
+    QDIA::TypeNameCache _typeNames;
+    AtomTable _atoms;
+};
+
+
+inline void DiaSymbolProvider::setProbing(bool probing)
+{
+    _probing = probing;
+}
+
+inline const QString& DiaSymbolProvider::pdbFileName() const
+{
+    return _pdbFileName;
+}
+
+
+#endif // DIASYMBOLPROVIDER_H
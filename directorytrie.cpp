@@ -0,0 +1,90 @@
+#include "directorytrie.h"
+
+#include "path.h"
+#include "symboltreemodel.h"
+
+#include <algorithm>
+
+
+DirectoryTrie::DirectoryTrie()
+{
+    clear();
+}
+
+void DirectoryTrie::clear()
+{
+    _nodes.clear();
+    _pending.clear();
+    _roots.clear();
+
+    Node root = { -1, QString(), SymbolTreeModel::RootNode, QHash<QString, int>() };
+    _nodes.append(root);
+}
+
+bool DirectoryTrie::insert(const Path& path, int module)
+{
+    if (path.size() < 2)
+        return false;
+
+    int node = RootNode;
+
+    for (int i = 0; i < path.size() - 1; ++i)
+    {
+        const QString& element = path.at(i);
+        QString folded = element.toCaseFolded();
+
+        auto it = _nodes.at(node).children.constFind(folded);
+        if (it != _nodes.at(node).children.constEnd())
+        {
+            node = it.value();
+            continue;
+        }
+
+        Node child = { node, element, -1, QHash<QString, int>() };
+        _nodes.append(child);
+
+        int id = _nodes.size() - 1;
+        _nodes[node].children.insert(folded, id);
+        node = id;
+    }
+
+    Object object = { node, module };
+    _pending.append(object);
+
+    return true;
+}
+
+void DirectoryTrie::attach(SymbolTreeModel* model)
+{
+    for (int i = 0; i < _pending.size(); ++i)
+    {
+        const Object& object = _pending.at(i);
+        model->addCompiland(attachNode(model, object.directory), object.module);
+    }
+
+    _pending.clear();
+}
+
+int DirectoryTrie::attachNode(SymbolTreeModel* model, int node)
+{
+    if (_nodes.at(node).attached >= 0)
+        return _nodes.at(node).attached;
+
+    int parent = _nodes.at(node).parent;
+    int attachedParent = attachNode(model, parent);
+    int position = -1;
+
+    // Drives and other top level directories are kept in order
+    if (parent == RootNode)
+    {
+        QString folded = _nodes.at(node).name.toCaseFolded();
+        auto it = std::lower_bound(_roots.begin(), _roots.end(), folded);
+        position = int(it - _roots.begin());
+        _roots.insert(position, folded);
+    }
+
+    int id = model->addGroup(attachedParent, position, SymbolTreeModel::Directory, _nodes.at(node).name);
+    _nodes[node].attached = id;
+
+    return id;
+}
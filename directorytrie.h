@@ -0,0 +1,65 @@
+#ifndef DIRECTORYTRIE_H
+#define DIRECTORYTRIE_H
+
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+class Path;
+class SymbolTreeModel;
+
+
+// Directory hierarchy of the object files, kept beside the Objects tree.
+// Children are hashed by their case-folded name, so placing an object costs
+// one lookup per path element no matter how many siblings a directory has.
+// Objects are collected first and attached to the model in one pass.
+class DirectoryTrie
+{
+public:
+    DirectoryTrie();
+
+    void clear();
+
+    // Files the object under the directories of the path, the last element is its file name
+    bool insert(const Path& path, int module);
+    // Adds every directory and object inserted since the last call to the model
+    void attach(SymbolTreeModel* model);
+
+    int pending() const;
+
+private:
+    enum { RootNode = 0 };
+
+    struct Node
+    {
+        int parent;
+        QString name;
+        // Model node once attached, -1 before
+        int attached;
+        QHash<QString, int> children;
+    };
+
+    struct Object
+    {
+        int directory;
+        int module;
+    };
+
+    int attachNode(SymbolTreeModel* model, int node);
+
+private:
+    QVector<Node> _nodes;
+    QVector<Object> _pending;
+    // Case-folded names of the top level directories, in the order the model shows them
+    QVector<QString> _roots;
+};
+
+
+inline int DirectoryTrie::pending() const
+{
+    return _pending.size();
+}
+
+
+#endif // DIRECTORYTRIE_H
@@ -0,0 +1,254 @@
+#include "fakesymbolprovider.h"
+
+#include "contributionindex.h"
+
+
+static const quint32 s_imageBase = 0x1000;
+
+FakeSymbolProvider::FakeSymbolProvider(int compilandCount, int symbolsPerCompiland)
+    : _compilandCount(qMax(0, compilandCount))
+    , _symbolsPerCompiland(qMax(1, symbolsPerCompiland))
+    , _open(false)
+{
+}
+
+bool FakeSymbolProvider::open(const QString& fileName)
+{
+    Q_UNUSED(fileName);
+
+    _open = true;
+    return true;
+}
+
+void FakeSymbolProvider::close()
+{
+    _open = false;
+}
+
+QVector<SymbolCompiland> FakeSymbolProvider::compilands()
+{
+    QVector<SymbolCompiland> result;
+    if (!_open)
+        return result;
+
+    result.reserve(_compilandCount);
+    for (int i = 0; i < _compilandCount; ++i)
+    {
+        int library = i / CompilandsPerLibrary;
+
+        SymbolCompiland compiland;
+        compiland.id = quint32(i);
+        compiland.name = QStringLiteral("C:\\synthetic\\lib%1\\module%2.obj").arg(library).arg(i);
+        compiland.libraryName = QStringLiteral("C:\\synthetic\\lib%1.lib").arg(library);
+        compiland.objectPath = compiland.name;
+        result.append(compiland);
+    }
+
+    return result;
+}
+
+QVector<SymbolSourceFile> FakeSymbolProvider::sourceFiles(quint32 compiland)
+{
+    QVector<SymbolSourceFile> result;
+    if (!_open || compiland >= quint32(_compilandCount))
+        return result;
+
+    // Each compiland has its own source and includes a rotating window of shared headers
+    int headers = qMin(int(SharedSourceFiles), _symbolsPerCompiland / 8 + 1);
+    result.reserve(headers + 1);
+
+    SymbolSourceFile source = { SharedSourceFiles + compiland,
+                                QStringLiteral("C:\\synthetic\\lib%1\\module%2.cpp")
+                                .arg(compiland / CompilandsPerLibrary).arg(compiland) };
+    result.append(source);
+
+    for (int i = 0; i < headers; ++i)
+    {
+        quint32 id = (compiland + quint32(i)) % SharedSourceFiles;
+        SymbolSourceFile header = { id, QStringLiteral("C:\\synthetic\\include\\header%1.h").arg(id) };
+        result.append(header);
+    }
+
+    return result;
+}
+
+bool FakeSymbolProvider::visitTypedefs(quint32 scope, const Visitor<SymbolTypedef>& visitor)
+{
+    if (!_open)
+        return false;
+
+    int perCompiland = _symbolsPerCompiland / 4 + 1;
+    int first = 0;
+    int count = _compilandCount * perCompiland;
+
+    if (scope != GlobalScope)
+    {
+        if (scope >= quint32(_compilandCount))
+            return true;
+
+        first = int(scope) * perCompiland;
+        count = perCompiland;
+    }
+
+    for (int i = first; i < first + count; ++i)
+    {
+        SymbolTypedef item = { QStringLiteral("type%1_t").arg(i),
+                               (i & 1) ? QStringLiteral("unsigned int") : QStringLiteral("struct record%1 *").arg(i) };
+        if (!filter().matches(item.name))
+            continue;
+
+        if (isCancelled() || !visitor(item))
+            return false;
+    }
+
+    return true;
+}
+
+bool FakeSymbolProvider::visitEnums(const Visitor<SymbolEnum>& visitor)
+{
+    if (!_open)
+        return false;
+
+    int count = _compilandCount * (_symbolsPerCompiland / 16 + 1);
+    for (int i = 0; i < count; ++i)
+    {
+        SymbolEnum item;
+        item.name = QStringLiteral("Enum%1").arg(i);
+        if (!filter().matches(item.name))
+            continue;
+
+        item.type = (i & 1) ? QStringLiteral("unsigned char") : QStringLiteral("int");
+
+        for (int j = 0; j < 4; ++j)
+        {
+            SymbolMember value = { QStringLiteral("Enum%1_Value%2").arg(i).arg(j), QString(), QString::number(j) };
+            item.values.append(value);
+        }
+
+        if (isCancelled() || !visitor(item))
+            return false;
+    }
+
+    return true;
+}
+
+bool FakeSymbolProvider::visitUserTypes(const Visitor<SymbolUserType>& visitor)
+{
+    if (!_open)
+        return false;
+
+    int count = _compilandCount * (_symbolsPerCompiland / 8 + 1);
+    for (int i = 0; i < count; ++i)
+    {
+        SymbolUserType item;
+        item.kind = (i % 3 == 0) ? QStringLiteral("class") : QStringLiteral("struct");
+        item.name = QStringLiteral("record%1").arg(i);
+        if (!filter().matches(item.name))
+            continue;
+
+        for (int j = 0; j < 4; ++j)
+        {
+            SymbolMember member = { QStringLiteral("field%1").arg(j), QStringLiteral("int"), QString() };
+            item.members.append(member);
+        }
+
+        if (isCancelled() || !visitor(item))
+            return false;
+    }
+
+    return true;
+}
+
+bool FakeSymbolProvider::visitFunctions(quint32 compiland, const Visitor<SymbolFunction>& visitor)
+{
+    if (!_open || compiland >= quint32(_compilandCount))
+        return false;
+
+    for (int i = 0; i < _symbolsPerCompiland; ++i)
+    {
+        SymbolFunction function;
+        function.name = QStringLiteral("module%1::function%2").arg(compiland).arg(i);
+        function.rva = functionRva(compiland, i);
+        if (!filter().matches(function.name))
+            continue;
+
+        if (isCancelled() || !visitor(function))
+            return false;
+    }
+
+    return true;
+}
+
+bool FakeSymbolProvider::sectionContributions(ContributionIndex* index)
+{
+    index->clear();
+    if (!_open)
+        return false;
+
+    index->reserve(_compilandCount);
+    for (int i = 0; i < _compilandCount; ++i)
+    {
+        index->add(functionRva(quint32(i), 0), quint32(_symbolsPerCompiland) * FunctionSize,
+                   quint32(i), ContributionIndex::Code | ContributionIndex::Execute);
+    }
+
+    index->build();
+    return true;
+}
+
+bool FakeSymbolProvider::findFunction(quint32 rva, SymbolRange* result)
+{
+    if (!_open || rva < s_imageBase)
+        return false;
+
+    quint32 index = (rva - s_imageBase) / FunctionSize;
+    quint32 compiland = index / quint32(_symbolsPerCompiland);
+    int function = int(index % quint32(_symbolsPerCompiland));
+    if (compiland >= quint32(_compilandCount))
+        return false;
+
+    result->rva = functionRva(compiland, function);
+    result->size = FunctionSize;
+    result->name = QStringLiteral("module%1::function%2").arg(compiland).arg(function);
+    result->lines.clear();
+
+    // Two statements per function, both in the compiland's own source
+    QString fileName = QStringLiteral("C:\\synthetic\\lib%1\\module%2.cpp")
+                       .arg(compiland / CompilandsPerLibrary).arg(compiland);
+    for (quint32 i = 0; i < 2; ++i)
+    {
+        SymbolLine line = { result->rva + i * (FunctionSize / 2), FunctionSize / 2,
+                            quint32(function) * 4 + i + 1, fileName };
+        result->lines.append(line);
+    }
+
+    return true;
+}
+
+bool FakeSymbolProvider::visitAddresses(const Visitor<SymbolAddress>& visitor)
+{
+    if (!_open)
+        return false;
+
+    // Compilands are laid out back to back, so this is already address order
+    for (int i = 0; i < _compilandCount; ++i)
+    {
+        for (int j = 0; j < _symbolsPerCompiland; ++j)
+        {
+            SymbolAddress address = { functionRva(quint32(i), j), FunctionSize, SymbolAddress::Function,
+                                      QStringLiteral("module%1::function%2").arg(i).arg(j) };
+            if (!filter().matches(address.name))
+                continue;
+
+            if (isCancelled() || !visitor(address))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+quint32 FakeSymbolProvider::functionRva(quint32 compiland, int function) const
+{
+    return s_imageBase + (compiland * quint32(_symbolsPerCompiland) + quint32(function)) * FunctionSize;
+}
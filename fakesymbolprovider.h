@@ -0,0 +1,46 @@
+#ifndef FAKESYMBOLPROVIDER_H
+#define FAKESYMBOLPROVIDER_H
+
+
+#include "symbolprovider.h"
+
+
+// Generates a deterministic synthetic program of any size for load-path benchmarks.
+// Every compiland gets symbolsPerCompiland functions and a share of the other kinds.
+class FakeSymbolProvider : public SymbolProvider
+{
+public:
+    enum
+    {
+        CompilandsPerLibrary = 16,
+        SharedSourceFiles = 64,
+        FunctionSize = 16
+    };
+
+public:
+    FakeSymbolProvider(int compilandCount, int symbolsPerCompiland);
+
+    bool open(const QString& fileName) override;
+    void close() override;
+
+    QVector<SymbolCompiland> compilands() override;
+    QVector<SymbolSourceFile> sourceFiles(quint32 compiland) override;
+    bool visitTypedefs(quint32 scope, const Visitor<SymbolTypedef>& visitor) override;
+    bool visitEnums(const Visitor<SymbolEnum>& visitor) override;
+    bool visitUserTypes(const Visitor<SymbolUserType>& visitor) override;
+    bool visitFunctions(quint32 compiland, const Visitor<SymbolFunction>& visitor) override;
+    bool sectionContributions(ContributionIndex* index) override;
+    bool findFunction(quint32 rva, SymbolRange* result) override;
+    bool visitAddresses(const Visitor<SymbolAddress>& visitor) override;
+
+private:
+    quint32 functionRva(quint32 compiland, int function) const;
+
+private:
+    int _compilandCount;
+    int _symbolsPerCompiland;
+    bool _open;
+};
+
+
+#endif // FAKESYMBOLPROVIDER_H
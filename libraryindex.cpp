@@ -0,0 +1,88 @@
+#include "libraryindex.h"
+
+
+LibraryIndex::LibraryIndex()
+    : _executable(-1)
+{
+}
+
+void LibraryIndex::clear()
+{
+    _libraries.clear();
+    _moduleLibraries.clear();
+    _moduleCompilands.clear();
+    _pathIds.clear();
+    _nameIds.clear();
+    _executable = -1;
+}
+
+int LibraryIndex::add(const SymbolCompiland& compiland, int module, const ContributionIndex& contributions)
+{
+    const QString& path = compiland.libraryName;
+
+    int library = _pathIds.value(path, -1);
+    if (library < 0)
+    {
+        int slash = qMax(path.lastIndexOf('\\'), path.lastIndexOf('/'));
+        QString name = (slash >= 0) ? path.mid(slash + 1) : path;
+
+        if (name.endsWith(".lib", Qt::CaseInsensitive))
+        {
+            QString folded = name.toCaseFolded();
+            library = _nameIds.value(folded, -1);
+            if (library < 0)
+            {
+                SymbolLibrary entry = { path, name, false, QVector<int>(), { 0, 0 } };
+                _libraries.append(entry);
+                library = _libraries.size() - 1;
+                _nameIds.insert(folded, library);
+            }
+        }
+        else
+        {
+            if (_executable < 0)
+            {
+                SymbolLibrary entry = { QString(), QStringLiteral("Executable"), true, QVector<int>(), { 0, 0 } };
+                _libraries.append(entry);
+                _executable = _libraries.size() - 1;
+            }
+            library = _executable;
+        }
+
+        _pathIds.insert(path, library);
+    }
+
+    SymbolLibrary& entry = _libraries[library];
+    entry.modules.append(module);
+
+    ContributionIndex::Totals totals = contributions.totals(compiland.id);
+    entry.totals.code += totals.code;
+    entry.totals.data += totals.data;
+
+    if (_moduleLibraries.size() <= module)
+    {
+        _moduleLibraries.resize(module + 1);
+        _moduleCompilands.resize(module + 1);
+    }
+    _moduleLibraries[module] = library;
+    _moduleCompilands[module] = compiland.id;
+
+    return library;
+}
+
+void LibraryIndex::recount(const ContributionIndex& contributions)
+{
+    for (int i = 0; i < _libraries.size(); ++i)
+    {
+        SymbolLibrary& library = _libraries[i];
+        library.totals.code = 0;
+        library.totals.data = 0;
+
+        for (int j = 0; j < library.modules.size(); ++j)
+        {
+            ContributionIndex::Totals totals = contributions.totals(_moduleCompilands.at(library.modules.at(j)));
+            library.totals.code += totals.code;
+            library.totals.data += totals.data;
+        }
+    }
+}
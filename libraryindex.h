@@ -0,0 +1,82 @@
+#ifndef LIBRARYINDEX_H
+#define LIBRARYINDEX_H
+
+
+#include "contributionindex.h"
+#include "symbolprovider.h"
+
+#include <QHash>
+#include <QVector>
+
+
+struct SymbolLibrary
+{
+    // Path as the first of its compilands recorded it
+    QString path;
+    QString name;
+    bool executable;
+    QVector<int> modules;
+    ContributionIndex::Totals totals;
+};
+
+
+// Compilands grouped by the library they were linked from. Libraries are
+// matched by file name regardless of case, everything that does not come
+// from a .lib shares a single executable group.
+class LibraryIndex
+{
+public:
+    LibraryIndex();
+
+    void clear();
+    // Files the module under its library, adding its code and data to the library's totals
+    int add(const SymbolCompiland& compiland, int module, const ContributionIndex& contributions);
+    // Sums the totals again when the contributions arrive after the modules
+    void recount(const ContributionIndex& contributions);
+
+    bool isEmpty() const;
+    int count() const;
+    const SymbolLibrary& at(int library) const;
+    int libraryOf(int module) const;
+
+    // Code and data of all the library's compilands
+    const ContributionIndex::Totals& totals(int library) const;
+
+private:
+    QVector<SymbolLibrary> _libraries;
+    QVector<int> _moduleLibraries;
+    QVector<quint32> _moduleCompilands;
+    // Recorded paths and case-folded file names, so a path is split only once
+    QHash<QString, int> _pathIds;
+    QHash<QString, int> _nameIds;
+    int _executable;
+};
+
+
+inline bool LibraryIndex::isEmpty() const
+{
+    return _libraries.isEmpty();
+}
+
+inline int LibraryIndex::count() const
+{
+    return _libraries.size();
+}
+
+inline const SymbolLibrary& LibraryIndex::at(int library) const
+{
+    return _libraries.at(library);
+}
+
+inline int LibraryIndex::libraryOf(int module) const
+{
+    return _moduleLibraries.value(module, -1);
+}
+
+inline const ContributionIndex::Totals& LibraryIndex::totals(int library) const
+{
+    return _libraries.at(library).totals;
+}
+
+
+#endif // LIBRARYINDEX_H
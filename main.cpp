@@ -2,7 +2,9 @@
 #include <QCommandLineParser>
 #include <QCommandLineOption>
 
+#include "fakesymbolprovider.h"
 #include "mainwindow.h"
+#include "symbolorder.h"
 
 
 int main(int argc, char *argv[])
@@ -17,12 +19,45 @@ int main(int argc, char *argv[])
     parser.addHelpOption();
     parser.addVersionOption();
     parser.addPositionalArgument("file", "The file to open.");
+    QCommandLineOption syntheticOption("synthetic",
+        "Load a generated program of <compilands> compilands instead of a file.", "compilands");
+    parser.addOption(syntheticOption);
+    QCommandLineOption symbolsOption("synthetic-symbols",
+        "Functions per generated compiland (default 100).", "count", "100");
+    parser.addOption(symbolsOption);
+    QCommandLineOption filterOption("filter",
+        "Load only symbols matching <pattern> (* and ? wildcards, /expression/ for a regular expression).", "pattern");
+    parser.addOption(filterOption);
+    QCommandLineOption caseOption("filter-case-sensitive", "Match the filter pattern case sensitively.");
+    parser.addOption(caseOption);
+    QCommandLineOption benchmarkOption("benchmark-sort",
+        "Time filling the Typedefs, Enums and UDTs docks for up to <rows> rows (at least 1024), "
+        "fail when the cost grows faster than n log n, and exit.", "rows");
+    parser.addOption(benchmarkOption);
     parser.process(application);
 
+    if (parser.isSet(benchmarkOption))
+        return SymbolOrder::benchmark(parser.value(benchmarkOption).toInt());
+
+    SymbolFilter filter = SymbolFilter::fromUserPattern(parser.value(filterOption),
+        parser.isSet(caseOption) ? Qt::CaseSensitive : Qt::CaseInsensitive);
+    if (!filter.isValid())
+        parser.showHelp(1);
+
     MainWindow mainWin;
     const QStringList posArgs = parser.positionalArguments();
-    if (!posArgs.isEmpty())
-        mainWin.openFile(posArgs.at(0));
+    if (parser.isSet(syntheticOption))
+    {
+        FakeSymbolProvider* provider = new FakeSymbolProvider(parser.value(syntheticOption).toInt(),
+                                                              parser.value(symbolsOption).toInt());
+        provider->setFilter(filter);
+        provider->open(QString());
+        mainWin.openProvider(provider, QStringLiteral("Synthetic"));
+    }
+    else if (!posArgs.isEmpty())
+    {
+        mainWin.openFile(posArgs.at(0), filter);
+    }
 
     mainWin.show();
     return application.exec();
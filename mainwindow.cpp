@@ -2,25 +2,33 @@
 
 #include <QtWidgets>
 #include <QDebug>
-#include <QMap>
+#include <QHash>
+#include <QSet>
+
+#include <algorithm>
 
 #include "mdichild.h"
+#include "nativesymbolprovider.h"
 #include "path.h"
+#include "pefile.h"
+#include "symbolorder.h"
+#include "symboltreemodel.h"
+
+#ifdef Q_OS_WIN
+#include "diasymbolprovider.h"
+#endif
 
 
 MainWindow::MainWindow()
     : mdiArea(new QMdiArea)
-    , _library(NULL)
-    , _diaDataSource(NULL)
-    , _diaSession(NULL)
-    , _diaSymbolGlobal(NULL)
+    , _objectCount(0)
 {
-    createDockedTree(&_treeModules, "Modules", QStringList({"Module", "Path"}));
-    createDockedTree(&_treeObjects, "Objects", QStringList({"Object", "Description"}));
-    createDockedTree(&_treeTest, "Test", QStringList({"Test"}));
-    createDockedTree(&_treeTypedefs, "Typedefs", QStringList({"Base Type", "New Type"}));
-    createDockedTree(&_treeEnums, "Enums", QStringList({"Name", "Value"}));
-    createDockedTree(&_treeUserTypes, "UDTs", QStringList({"Type", "Description"}));
+    createDockedTree(&_treeModules, &_modelModules, "Modules", QStringList({"Module", "Path", "Code", "Data"}));
+    createDockedTree(&_treeObjects, &_modelObjects, "Objects", QStringList({"Object", "Description", "Code", "Data"}));
+    createDockedTree(&_treeTypedefs, &_modelTypedefs, "Typedefs", QStringList({"Base Type", "New Type"}));
+    createDockedTree(&_treeEnums, &_modelEnums, "Enums", QStringList({"Name", "Value"}));
+    createDockedTree(&_treeUserTypes, &_modelUserTypes, "UDTs", QStringList({"Type", "Description"}));
+    createAddressDock();
 
 
     mdiArea->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
@@ -33,6 +41,21 @@ MainWindow::MainWindow()
     createStatusBar();
     updateMenus();
 
+    connect(&_loader, &SymbolLoader::progress, this, &MainWindow::loadProgress);
+    connect(&_loader, &SymbolLoader::contributionsLoaded, this, [this](const ContributionIndex& contributions)
+    {
+        _symbols.setContributions(contributions);
+    });
+    connect(&_loader, &SymbolLoader::addressesLoaded, this, [this](const AddressMap& addresses)
+    {
+        _symbols.setAddresses(addresses);
+    });
+    connect(&_loader, &SymbolLoader::modulesLoaded, this, &MainWindow::modulesLoaded);
+    connect(&_loader, &SymbolLoader::typedefsLoaded, this, &MainWindow::typedefsLoaded);
+    connect(&_loader, &SymbolLoader::enumsLoaded, this, &MainWindow::enumsLoaded);
+    connect(&_loader, &SymbolLoader::userTypesLoaded, this, &MainWindow::userTypesLoaded);
+    connect(&_loader, &SymbolLoader::finished, this, &MainWindow::loadFinished);
+
     readSettings();
 
     setWindowTitle("UnDebug");
@@ -57,126 +80,155 @@ void MainWindow::open()
         openFile(fileName);
 }
 
-bool MainWindow::openFile(const QString &fileName)
+void MainWindow::openFiltered()
 {
-    closeFile();
-
-    _library = LoadLibraryW(L"msdia140.dll");
-    if (!_library)
-        return false;
+    const QString fileName = QFileDialog::getOpenFileName(this);
+    if (fileName.isEmpty())
+        return;
 
-    HRESULT (WINAPI *GetClassObject)(REFCLSID rclsid, REFIID riid, LPVOID* ppv);
+    bool ok = false;
+    QString pattern = QInputDialog::getText(this, tr("Open Filtered"),
+                                            tr("Load only symbols matching (* and ? wildcards, /expression/ for a regular expression):"),
+                                            QLineEdit::Normal, QString(), &ok);
+    if (!ok)
+        return;
 
-    *((FARPROC*) &GetClassObject) = GetProcAddress(_library, "DllGetClassObject");
-    if (!GetClassObject)
+    SymbolFilter filter = SymbolFilter::fromUserPattern(pattern);
+    if (!filter.isValid())
     {
-        FreeLibrary(_library);
-        _library = NULL;
-        return false;
+        statusBar()->showMessage(tr("Invalid regular expression: %1").arg(filter.pattern()), 2000);
+        return;
     }
 
-    IClassFactory* factory = nullptr;
-    HRESULT result = GetClassObject(__uuidof(DiaSource), IID_IClassFactory, (LPVOID*) &factory);
-    if (FAILED(result))
-    {
-        FreeLibrary(_library);
-        _library = NULL;
-        return false;
-    }
+    openFile(fileName, filter);
+}
 
-    result = factory->CreateInstance(NULL, __uuidof(IDiaDataSource), (void**) &_diaDataSource);
-    factory->Release();
+bool MainWindow::openFile(const QString &fileName, const SymbolFilter& filter)
+{
+    closeFile();
 
-    QFileInfo fileInfo(fileName);
+    // Find the image's PDB through the local stores before DIA probes its search path
+    QString pdbFileName = fileName;
+    PeDebugInfo info;
+    bool searching = PeFile::isImage(fileName) && PeFile::readDebugInfo(fileName, &info) &&
+                     !info.pdbName().isEmpty();
+    bool missing = false;
 
-    if (SUCCEEDED(result))
+    if (searching)
     {
-        if (fileInfo.suffix().compare("exe", Qt::CaseInsensitive) == 0)
-        {
-            result = _diaDataSource->loadDataForExe((wchar_t*) fileName.utf16(), NULL, NULL);
-        }
-        else
+        // Asked before locate(), which remembers a miss in the stores itself
+        missing = _symbolStore.isMissing(info.pdbName(), info.symbolStoreKey());
+
+        QString located = _symbolStore.locate(fileName);
+        if (!located.isEmpty())
         {
-            result = _diaDataSource->loadDataFromPdb((wchar_t*) fileName.utf16());
+            pdbFileName = located;
+            searching = false;
         }
     }
 
-    if (SUCCEEDED(result))
-        result = _diaDataSource->openSession(&_diaSession);
+    QScopedPointer<SymbolProvider> provider;
 
-    if (SUCCEEDED(result))
-        result = _diaSession->get_globalScope(&_diaSymbolGlobal);
+#ifdef Q_OS_WIN
+    DiaSymbolProvider* dia = new DiaSymbolProvider();
+    provider.reset(dia);
+    provider->setFilter(filter);
+    // A search that failed recently is not repeated until it expires
+    dia->setProbing(!missing);
+    if (provider->open(pdbFileName))
+    {
+        if (searching && !dia->pdbFileName().isEmpty())
+            _symbolStore.addFound(info.pdbName(), info.symbolStoreKey(), dia->pdbFileName());
+        return openProvider(provider.take(), fileName);
+    }
+#endif
 
-    if (FAILED(result))
+    // Without DIA a PDB can still be read natively
+    provider.reset(new NativeSymbolProvider());
+    provider->setFilter(filter);
+    if (!provider->open(pdbFileName))
     {
-        if (_diaSymbolGlobal)
-        {
-            _diaSymbolGlobal->Release();
-            _diaSymbolGlobal = NULL;
-        }
-        if (_diaSession)
+        if (searching)
         {
-            _diaSession->Release();
-            _diaSession = NULL;
+            _symbolStore.addMissing(info.pdbName(), info.symbolStoreKey());
+            statusBar()->showMessage(missing ? tr("No PDB matching %1 was found, the search failed recently")
+                                                   .arg(info.pdbName())
+                                             : tr("No PDB matching %1 was found").arg(info.pdbName()));
         }
-        if (_diaDataSource)
+        else
         {
-            _diaDataSource->Release();
-            _diaDataSource = NULL;
+            statusBar()->showMessage(tr("Cannot open %1").arg(QDir::toNativeSeparators(pdbFileName)));
         }
-        FreeLibrary(_library);
-        _library = NULL;
         return false;
     }
 
-    readModules();
-    readSourceFiles();
-    readTypedefs();
-    readEnums();
-    readUserTypes();
+    return openProvider(provider.take(), fileName);
+}
+
+bool MainWindow::openProvider(SymbolProvider* provider, const QString& fileName)
+{
+    closeFile();
 
-    prependToRecentFiles(fileName);
+    _provider.reset(provider);
 
-    setWindowTitle(fileInfo.fileName() + " - UnDebug");
+    // The docks fill in as the worker hands over what it has read
+    _loadProgress->setRange(0, 0);
+    _loadProgress->show();
+    _loadCancel->show();
+    _loader.start(_provider.data(), _symbols.loadMode());
+
+    if (QFileInfo::exists(fileName))
+        prependToRecentFiles(fileName);
+
+    setWindowTitle(QFileInfo(fileName).fileName() + " - UnDebug");
 
     return true;
 }
 
 void MainWindow::closeFile()
 {
-    _treeModules->clear();
+    // A half-finished load is dropped before anything it feeds is cleared
+    _loader.stop();
+    _loadProgress->hide();
+    _loadCancel->hide();
+    _loadCancel->setEnabled(true);
+
+    // The models show the database's records, so they go first
+    _modelModules->clear();
+    _libraryNodes.clear();
     QDockWidget* dock = qobject_cast<QDockWidget*>(_treeModules->parent());
     if (dock)
         dock->setWindowTitle("Modules");
 
-    _treeObjects->clear();
+    _modelObjects->clear();
+    _objectDirectories.clear();
     dock = qobject_cast<QDockWidget*>(_treeObjects->parent());
     if (dock)
         dock->setWindowTitle("Objects");
 
-    if (_diaSymbolGlobal)
-    {
-        _diaSymbolGlobal->Release();
-        _diaSymbolGlobal = NULL;
-    }
-    if (_diaSession)
-    {
-        _diaSession->Release();
-        _diaSession = NULL;
-    }
-    if (_diaDataSource)
+    _modelTypedefs->clear();
+    _modelEnums->clear();
+    _modelUserTypes->clear();
+    _objectCount = 0;
+
+    _resolver.setProvider(nullptr);
+    _resolver.setAddresses(nullptr);
+
+    if (_provider)
     {
-        _diaDataSource->Release();
-        _diaDataSource = NULL;
+        _provider->close();
+        _provider.reset();
     }
-    FreeLibrary(_library);
-    _library = NULL;
+
+    _symbols.clear();
 
     setWindowTitle("UnDebug");
 }
 
 static inline QString recentFilesKey() { return QStringLiteral("recentFileList"); }
 static inline QString fileKey() { return QStringLiteral("file"); }
+static inline QString symbolStoresKey() { return QStringLiteral("symbolStores"); }
+static inline QString symbolIndexFile() { return qApp->applicationDirPath() + "/symstore.index"; }
 
 static QStringList readRecentFiles(QSettings &settings)
 {
@@ -360,27 +412,105 @@ MdiChild *MainWindow::createMdiChild()
     return child;
 }
 
-void MainWindow::createDockedTree(QTreeWidget** widget, const QString& name,
+void MainWindow::createDockedTree(QTreeView** view, SymbolTreeModel** model, const QString& name,
                                   const QStringList& header)
 {
-    (*widget) = new QTreeWidget();
-    (*widget)->setMinimumWidth(350);
+    (*model) = new SymbolTreeModel(&_symbols, header, this);
 
-    if (!header.isEmpty())
-    {
-        QTreeWidgetItem* itemHeader = new QTreeWidgetItem();
-        for (int i = 0; i < header.size(); ++i)
-            itemHeader->setText(i, header.at(i));
-
-        (*widget)->setHeaderItem(itemHeader);
-    }
+    (*view) = new QTreeView();
+    (*view)->setMinimumWidth(350);
+    // Rows are all one line, this spares the view measuring each of them
+    (*view)->setUniformRowHeights(true);
+    (*view)->setModel(*model);
 
     QDockWidget* dockModules = new QDockWidget(name, this);
     dockModules->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
-    dockModules->setWidget(*widget);
+    dockModules->setWidget(*view);
     addDockWidget(Qt::LeftDockWidgetArea, dockModules);
 }
 
+void MainWindow::createAddressDock()
+{
+    QWidget* widget = new QWidget();
+    QVBoxLayout* layout = new QVBoxLayout(widget);
+
+    _addressBase = new QLineEdit();
+    _addressBase->setPlaceholderText("Image base (addresses are RVAs when empty)");
+    layout->addWidget(_addressBase);
+
+    _addressInput = new QPlainTextEdit();
+    _addressInput->setPlaceholderText("One address per line, stack traces can be pasted as is");
+    layout->addWidget(_addressInput);
+
+    QPushButton* resolveButton = new QPushButton("Resolve");
+    connect(resolveButton, &QPushButton::clicked, this, &MainWindow::resolveAddresses);
+    layout->addWidget(resolveButton);
+
+    QDockWidget* dock = new QDockWidget("Address", this);
+    dock->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
+    dock->setWidget(widget);
+    addDockWidget(Qt::RightDockWidgetArea, dock);
+}
+
+void MainWindow::resolveAddresses()
+{
+    if (!_provider)
+        return;
+
+    bool ok = false;
+    quint64 base = _addressBase->text().trimmed().remove(QStringLiteral("0x"), Qt::CaseInsensitive).toULongLong(&ok, 16);
+    if (!ok)
+        base = 0;
+
+    // Prefer explicit hex literals, bare numbers must be long enough not to match words
+    static const QRegularExpression prefixed(QStringLiteral("0[xX]([0-9a-fA-F]+)"));
+    static const QRegularExpression bare(QStringLiteral("\\b([0-9a-fA-F]{8,16})\\b"));
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QStringList report;
+    int resolved = 0;
+    const QStringList lines = _addressInput->toPlainText().split(QLatin1Char('\n'));
+    for (const QString& text : lines)
+    {
+        QRegularExpressionMatch match = prefixed.match(text);
+        if (!match.hasMatch())
+            match = bare.match(text);
+        if (!match.hasMatch())
+            continue;
+
+        quint64 address = match.captured(1).toULongLong(nullptr, 16);
+        if (base && address >= base)
+            address -= base;
+
+        SymbolLocation location;
+        if (address > 0xFFFFFFFFull || !_resolver.resolve(quint32(address), &location))
+        {
+            report << QStringLiteral("%1  <unknown>").arg(match.captured(0));
+            continue;
+        }
+
+        QString line = QStringLiteral("%1  %2+0x%3").arg(match.captured(0), location.function)
+                       .arg(location.offset, 0, 16);
+        if (!location.fileName.isEmpty())
+            line += QStringLiteral("  %1(%2)").arg(location.fileName).arg(location.line);
+
+        report << line;
+        ++resolved;
+    }
+
+    qint64 elapsed = timer.nsecsElapsed();
+
+    auto mdi = createMdiChild();
+    mdi->setPlainText(report.join(QLatin1Char('\n')));
+    mdi->show();
+
+    statusBar()->showMessage(QStringLiteral("Resolved %1 of %2 addresses in %3 us, cache %4 hits, %5 misses")
+                             .arg(resolved).arg(report.size()).arg(elapsed / 1000)
+                             .arg(_resolver.hits()).arg(_resolver.misses()));
+}
+
 void MainWindow::createActions()
 {
     QMenu *fileMenu = menuBar()->addMenu(tr("&File"));
@@ -394,6 +524,9 @@ void MainWindow::createActions()
     fileMenu->addAction(openAct);
     fileToolBar->addAction(openAct);
 
+    QAction *openFilteredAct = fileMenu->addAction(tr("Open &Filtered..."), this, &MainWindow::openFiltered);
+    openFilteredAct->setStatusTip(tr("Open a file loading only the symbols that match a pattern"));
+
     const QIcon saveIcon = QIcon::fromTheme("document-save", QIcon(":/images/save.png"));
     saveAct = new QAction(saveIcon, tr("&Save"), this);
     saveAct->setShortcuts(QKeySequence::Save);
@@ -410,6 +543,13 @@ void MainWindow::createActions()
 
     fileMenu->addSeparator();
 
+    QAction *storesAct = fileMenu->addAction(tr("Symbol S&tores..."), this, &MainWindow::editSymbolStores);
+    storesAct->setStatusTip(tr("Choose the local symbol stores searched for the PDBs of images"));
+    QAction *indexAct = fileMenu->addAction(tr("Rebuild Symbol &Index"), this, &MainWindow::rebuildSymbolIndex);
+    indexAct->setStatusTip(tr("Scan the symbol stores again"));
+
+    fileMenu->addSeparator();
+
     QMenu *recentMenu = fileMenu->addMenu(tr("Recent..."));
     connect(recentMenu, &QMenu::aboutToShow, this, &MainWindow::updateRecentFileActions);
     recentFileSubMenuAct = recentMenu->menuAction();
@@ -504,6 +644,17 @@ void MainWindow::createActions()
 
 void MainWindow::createStatusBar()
 {
+    _loadProgress = new QProgressBar();
+    _loadProgress->setMaximumWidth(200);
+    _loadProgress->hide();
+    statusBar()->addPermanentWidget(_loadProgress);
+
+    _loadCancel = new QPushButton(tr("Cancel"));
+    _loadCancel->setToolTip(tr("Stop loading, the symbols read so far are kept"));
+    _loadCancel->hide();
+    connect(_loadCancel, &QPushButton::clicked, this, &MainWindow::cancelLoad);
+    statusBar()->addPermanentWidget(_loadCancel);
+
     statusBar()->showMessage(tr("Ready"));
 }
 
@@ -519,12 +670,115 @@ void MainWindow::readSettings()
     } else {
         restoreGeometry(geometry);
     }
+
+    _symbolStore.setDirectories(settings.value(symbolStoresKey()).toStringList());
+    _symbolStore.loadIndex(symbolIndexFile());
 }
 
 void MainWindow::writeSettings()
 {
     QSettings settings(qApp->applicationDirPath() + "/undebug.ini", QSettings::IniFormat);
     settings.setValue("geometry", saveGeometry());
+    settings.setValue(symbolStoresKey(), _symbolStore.directories());
+    _symbolStore.saveIndex(symbolIndexFile());
+}
+
+void MainWindow::editSymbolStores()
+{
+    bool ok = false;
+    QString text = QInputDialog::getMultiLineText(this, tr("Symbol Stores"),
+                                                  tr("Local symbol store directories, one per line:"),
+                                                  _symbolStore.directories().join(QLatin1Char('\n')), &ok);
+    if (!ok)
+        return;
+
+    _symbolStore.setDirectories(text.split(QLatin1Char('\n'), Qt::SkipEmptyParts));
+    writeSettings();
+}
+
+void MainWindow::rebuildSymbolIndex()
+{
+    _symbolStore.rebuildIndex();
+    _symbolStore.saveIndex(symbolIndexFile());
+    statusBar()->showMessage(tr("Symbol index rebuilt"), 2000);
+}
+
+void MainWindow::cancelLoad()
+{
+    _loader.cancel();
+    _loadCancel->setEnabled(false);
+    statusBar()->showMessage(tr("Cancelling..."));
+}
+
+void MainWindow::loadProgress(int phase, int done, int total)
+{
+    static const char* const phases[SymbolDatabase::PhaseCount] =
+    {
+        QT_TR_NOOP("Reading section contributions"),
+        QT_TR_NOOP("Sweeping symbol addresses"),
+        QT_TR_NOOP("Reading modules"),
+        QT_TR_NOOP("Reading typedefs"),
+        QT_TR_NOOP("Reading enums"),
+        QT_TR_NOOP("Reading user types")
+    };
+
+    if (phase < 0 || phase >= SymbolDatabase::PhaseCount || !_loadCancel->isEnabled())
+        return;
+
+    // Phases of unknown size show a busy indicator
+    _loadProgress->setRange(0, total);
+    _loadProgress->setValue(done);
+
+    QString message = tr(phases[phase]);
+    if (total > 0)
+        message += QStringLiteral(" (%1/%2)").arg(done).arg(total);
+    statusBar()->showMessage(message + QStringLiteral("..."));
+}
+
+void MainWindow::modulesLoaded(const QVector<SymbolModule>& modules)
+{
+    int first = _symbols.modules().size();
+    _symbols.appendModules(modules);
+    readModules(first);
+}
+
+void MainWindow::typedefsLoaded(const QVector<SymbolTypedef>& typedefs)
+{
+    _symbols.setTypedefs(typedefs);
+    readTypedefs();
+}
+
+void MainWindow::enumsLoaded(const QVector<SymbolEnum>& enums)
+{
+    _symbols.setEnums(enums);
+    readEnums();
+}
+
+void MainWindow::userTypesLoaded(const QVector<SymbolUserType>& userTypes)
+{
+    _symbols.setUserTypes(userTypes);
+    readUserTypes();
+}
+
+void MainWindow::loadFinished(bool completed)
+{
+    _loadProgress->hide();
+    _loadCancel->hide();
+    _loadCancel->setEnabled(true);
+
+    // The provider is free for other users only now
+    _resolver.setProvider(_provider.data());
+    _resolver.setAddresses(&_symbols.addresses());
+    readSourceFiles();
+
+    QString statistics = _provider->statistics();
+    if (!_provider->filter().isEmpty())
+        statistics = tr("Filtered by %1").arg(_provider->filter().toString()) +
+                     (statistics.isEmpty() ? QString() : QStringLiteral(", ") + statistics);
+    if (!completed)
+        statistics = tr("Loading cancelled") + (statistics.isEmpty() ? QString() : QStringLiteral(", ") + statistics);
+
+    statusBar()->showMessage(statistics.isEmpty() ? tr("Ready") : statistics);
 }
 
 MdiChild *MainWindow::activeMdiChild() const
@@ -547,103 +801,111 @@ QMdiSubWindow *MainWindow::findMdiChild(const QString &fileName) const
     return nullptr;
 }
 
-void MainWindow::readModules()
+void MainWindow::readModules(int first)
 {
-    /*
-    QTreeWidgetItem* roots[SymTagMax] = { nullptr };
-    DWORD tag;
+    const QVector<SymbolModule>& modules = _symbols.modules();
 
-    QVector<IDiaSymbol*> symbols = QDIA::findChildren(_diaSymbolGlobal, SymTagNull);
-    for (int i = 0; i < symbols.size(); ++i)
-    {
-        IDiaSymbol* symbol = symbols.at(i);
-        if (FAILED(symbol->get_symTag(&tag)))
-            return;
+    // The first batch is shown in one reset, later ones join the trees row by row
+    bool build = _modelModules->childCount(SymbolTreeModel::RootNode) == 0;
+    if (build)
+        _modelModules->beginBuild();
+    for (int i = first; i < modules.size(); ++i)
+        addModule(i);
+    if (build)
+        _modelModules->endBuild();
 
-        if (tag >= SymTagMax)
-        {
-            qDebug() << "Invalid tag value" << tag;
-            continue;
-        }
-
-        if (!roots[tag])
-        {
-            roots[tag] = new QTreeWidgetItem(_treeTest);
-            roots[tag]->setText(0, QDIA::getSymbolType(symbol));
-            roots[tag]->setIcon(0, QIcon(":/images/folder.png"));
-        }
-
-        QString name = QDIA::getName(symbol);
-        if (name.isEmpty())
-            name = QStringLiteral("(empty)");
-
-        QTreeWidgetItem* item = new QTreeWidgetItem(roots[tag]);
-        item->setText(0, name);
+    for (int i = first; i < modules.size(); ++i)
+    {
+        if (addObject(i))
+            _objectCount++;
     }
-    */
-
 
-    int objCounter = 0;
+    build = _modelObjects->childCount(SymbolTreeModel::RootNode) == 0;
+    if (build)
+        _modelObjects->beginBuild();
+    _objectDirectories.attach(_modelObjects);
+    if (build)
+        _modelObjects->endBuild();
 
-    QVector<IDiaSymbol*> compilands = QDIA::findChildren(_diaSymbolGlobal, SymTagCompiland);
-    for (int i = 0; i < compilands.size(); ++i)
+    if (first == 0)
     {
-        addModule(compilands.at(i));
-        if (addObject(compilands.at(i)))
-            objCounter++;
+        _treeModules->resizeColumnToContents(0);
+        _treeObjects->resizeColumnToContents(0);
     }
-
-    _treeModules->resizeColumnToContents(0);
-    _treeObjects->resizeColumnToContents(0);
     QDockWidget* dock = qobject_cast<QDockWidget*>(_treeModules->parent());
     if (dock)
-        dock->setWindowTitle(QStringLiteral("Modules (%1)").arg(_treeModules->topLevelItemCount()));
+        dock->setWindowTitle(QStringLiteral("Modules (%1)").arg(_modelModules->rowCount()));
 
     dock = qobject_cast<QDockWidget*>(_treeObjects->parent());
     if (dock)
-        dock->setWindowTitle(QStringLiteral("Objects (%1)").arg(objCounter));
+        dock->setWindowTitle(QStringLiteral("Objects (%1)").arg(_objectCount));
 }
 
 void MainWindow::readSourceFiles()
 {
-    QMap<QString, QList<Path>> map;
+    // Each distinct file is hashed once to give its path and its file name an
+    // id, grouping and duplicate checks compare ids only
+    QSet<quint32> seen;
+    QHash<QString, int> pathIds;
+    QHash<QString, int> nameIds;
+    QVector<QString> names;
+    QVector<QVector<int>> groups;
+    QVector<Path> paths;
 
-    QVector<IDiaSymbol*> compilands = QDIA::findChildren(_diaSymbolGlobal, SymTagCompiland);
-    for (int i = 0; i < compilands.size(); ++i)
+    const QVector<SymbolModule>& modules = _symbols.modules();
+    for (int i = 0; i < modules.size(); ++i)
     {
-        QVector<IDiaSourceFile*> files = QDIA::findSourceFiles(_diaSession, compilands.at(i));
+        const QVector<SymbolSourceFile>& files = modules.at(i).sourceFiles;
         for (int j = 0; j < files.size(); ++j)
         {
-            IDiaSourceFile* file = files.at(j);
-            QString fileName = QDIA::getFileName(file);
-            Path path(fileName);
-            QList<Path>& plist = map[path.fileName().toLower()];
-            bool found = false;
-            for (int k = 0; k < plist.size(); ++k)
+            const SymbolSourceFile& file = files.at(j);
+
+            // The same file is listed by every compiland that includes it
+            if (seen.contains(file.id))
+                continue;
+
+            seen.insert(file.id);
+
+            // Paths differing only in case or separators are one file, as Path::compare() has it
+            Path path(file.fileName);
+            QString folded = path.path(Path::Relative).toCaseFolded();
+            if (pathIds.contains(folded))
+                continue;
+
+            pathIds.insert(folded, paths.size());
+            paths.append(path);
+
+            QString name = path.fileName().toCaseFolded();
+            int nameId = nameIds.value(name, -1);
+            if (nameId < 0)
             {
-                if (plist.at(k).compare(path) == 0)
-                {
-                    found = true;
-                    break;
-                }
+                nameId = names.size();
+                nameIds.insert(name, nameId);
+                names.append(name);
+                groups.append(QVector<int>());
             }
-            if (!found)
-                plist << path;
+            groups[nameId].append(paths.size() - 1);
         }
     }
 
+    QVector<int> order;
+    for (int i = 0; i < groups.size(); ++i)
+    {
+        if (groups.at(i).size() > 1)
+            order.append(i);
+    }
+
+    std::sort(order.begin(), order.end(), [&names](int left, int right) { return names.at(left) < names.at(right); });
+
     auto mdi = createMdiChild();
 
-    for (auto it = map.constBegin(); it != map.constEnd(); ++it)
+    for (int i = 0; i < order.size(); ++i)
     {
-        const QList<Path>& plist = it.value();
+        const QVector<int>& group = groups.at(order.at(i));
 
-        if (plist.size() < 2)
-            continue;
-
-        QString str = it.key() + ": [";
-        for (int i = 0; i < plist.size(); ++i)
-            str += plist.at(i).path() + "; ";
+        QString str = names.at(order.at(i)) + ": [";
+        for (int j = 0; j < group.size(); ++j)
+            str += paths.at(group.at(j)).path() + "; ";
 
         str += ']';
         mdi->append(str);
@@ -653,426 +915,59 @@ void MainWindow::readSourceFiles()
 
 void MainWindow::readTypedefs()
 {
-    QVector<IDiaSymbol*> typedefs = QDIA::findChildren(_diaSymbolGlobal, SymTagTypedef);
-    for (int i = 0; i < typedefs.size(); ++i)
-    {
-        addTypedef(typedefs.at(i), nullptr);
-    }
+    _modelTypedefs->beginBuild();
+    _modelTypedefs->setTopLevel(SymbolTreeModel::Typedef, SymbolOrder::typedefs(_symbols.typedefs()));
+    _modelTypedefs->endBuild();
 
     _treeTypedefs->resizeColumnToContents(0);
 }
 
 void MainWindow::readEnums()
 {
-    QVector<IDiaSymbol*> enums = QDIA::findChildren(_diaSymbolGlobal, SymTagEnum);
-    for (int i = 0; i < enums.size(); ++i)
-    {
-        addEnum(enums.at(i), nullptr);
-    }
+    _modelEnums->beginBuild();
+    _modelEnums->setTopLevel(SymbolTreeModel::Enum, SymbolOrder::enums(_symbols.enums()));
+    _modelEnums->endBuild();
+
     _treeEnums->resizeColumnToContents(0);
 }
 
 void MainWindow::readUserTypes()
 {
-    QVector<IDiaSymbol*> udts = QDIA::findChildren(_diaSymbolGlobal, SymTagUDT);
-    for (int i = 0; i < udts.size(); ++i)
-    {
-        addUserType(udts.at(i), nullptr);
-    }
-    _treeEnums->resizeColumnToContents(0);
+    _modelUserTypes->beginBuild();
+    _modelUserTypes->setTopLevel(SymbolTreeModel::UserType, SymbolOrder::userTypes(_symbols.userTypes()));
+    _modelUserTypes->endBuild();
+
+    _treeUserTypes->resizeColumnToContents(0);
 }
 
-void MainWindow::addModule(IDiaSymbol* compiland)
+void MainWindow::addModule(int index)
 {
-    QString path = QDIA::getName(compiland);
-    QString libraryPath = QDIA::getLibraryName(compiland);
-    QString realPath = QDIA::getEnvPath(compiland);
-
-    QString name;
-    QString libraryName;
-
-    int slash = qMax(path.lastIndexOf('\\'), path.lastIndexOf('/'));
-    name = (slash >= 0) ? path.mid(slash + 1) : path;
-    slash = qMax(libraryPath.lastIndexOf('\\'), libraryPath.lastIndexOf('/'));
-    libraryName = (slash >= 0) ? libraryPath.mid(slash + 1) : libraryPath;
-
-    Qt::CaseSensitivity cs = Qt::CaseInsensitive;
-    bool isLibrary = libraryName.endsWith(".lib", cs);
-
-    if (!isLibrary)
-        libraryName = QLatin1String("Executable");
-
-    QTreeWidgetItem* rootItem = nullptr;
-    for (int i = 0; i < _treeModules->topLevelItemCount(); ++i)
-    {
-        if (_treeModules->topLevelItem(i)->text(0).compare(libraryName, cs) == 0)
-        {
-            rootItem = _treeModules->topLevelItem(i);
-            break;
-        }
-    }
-
-    if (!rootItem)
-    {
-        rootItem = new QTreeWidgetItem();
-        rootItem->setText(0, libraryName);
-        if (isLibrary)
-        {
-            rootItem->setIcon(0, QIcon(":/images/books_stack.png"));
-            rootItem->setText(1, libraryPath);
-            rootItem->setToolTip(1, rootItem->text(1));
-            _treeModules->addTopLevelItem(rootItem);
-        }
-        else
-        {
-            rootItem->setIcon(0, QIcon(":/images/file_extension_exe.png"));
-            _treeModules->insertTopLevelItem(0, rootItem);
-        }
-    }
+    int library = _symbols.libraries().libraryOf(index);
+    if (library < 0)
+        return;
 
-    QTreeWidgetItem* item = new QTreeWidgetItem(rootItem);
-    item->setText(0, name);
-    item->setText(1, realPath.isEmpty() ? path : realPath);
-    item->setToolTip(1, item->text(1));
+    // Model node of every library seen so far, by library id
+    while (_libraryNodes.size() <= library)
+        _libraryNodes.append(-1);
 
+    if (_libraryNodes.at(library) < 0)
+        _libraryNodes[library] = _modelModules->addLibrary(library);
 
-    if (name.endsWith(".res", cs))
-    {
-        item->setIcon(0, QIcon(":/images/resources.png"));
-    }
-    else if (name.endsWith(".dll", cs))
-    {
-        item->setIcon(0, QIcon(":/images/file_extension_dll.png"));
-    }
-    else if (name.endsWith(".obj", cs))
-    {
-        item->setIcon(0, QIcon(":/images/module.png"));
-    }
-    else
-    {
-        item->setIcon(0, QIcon(":/images/page_error.png"));
-    }
-
-    addSymbols(compiland, item);
-    addSourceFiles(compiland, item);
+    _modelModules->addCompiland(_libraryNodes.at(library), index);
 }
 
-bool MainWindow::addObject(IDiaSymbol* compiland)
+bool MainWindow::addObject(int index)
 {
+    const SymbolCompiland& compiland = _symbols.modules().at(index).compiland;
     Qt::CaseSensitivity cs = Qt::CaseInsensitive;
 
-    QString path = QDIA::getName(compiland);
+    const QString& path = compiland.name;
     if (!path.endsWith(".obj", cs))
         return false;
 
-    QString realPath = QDIA::getEnvPath(compiland);
-    QString libraryPath = QDIA::getLibraryName(compiland);
-
-    QString name;
-    QString libraryName;
-
-    int slash = qMax(path.lastIndexOf('\\'), path.lastIndexOf('/'));
-    name = (slash >= 0) ? path.mid(slash + 1) : path;
-    slash = qMax(libraryPath.lastIndexOf('\\'), libraryPath.lastIndexOf('/'));
-    libraryName = (slash >= 0) ? libraryPath.mid(slash + 1) : libraryPath;
-
-    //bool isLibrary = libraryName.endsWith(".lib", cs);
+    const QString& realPath = compiland.objectPath;
 
     Path pathTree = realPath.isEmpty() ? ("UNRESOLVED/" + path) : realPath;
 
-    QTreeWidgetItem* root = nullptr;
-
-    for (int i = 0; i < pathTree.size() - 1; ++i)
-    {
-        QString element = pathTree.at(i);
-
-        if (i == 0)
-        {
-            int sorted = _treeObjects->topLevelItemCount();
-
-            for (int j = 0; j < _treeObjects->topLevelItemCount(); ++j)
-            {
-                int check = element.compare(_treeObjects->topLevelItem(j)->text(0), cs);
-
-                if (check > 0)
-                {
-                    sorted = j;
-                }
-                else if (check == 0)
-                {
-                    root = _treeObjects->topLevelItem(j);
-                    break;
-                }
-            }
-            if (!root)
-            {
-                root = new QTreeWidgetItem();
-                root->setText(0, element);
-                root->setIcon(0, QIcon(":/images/drive.png"));
-                _treeObjects->insertTopLevelItem(sorted, root);
-            }
-            continue;
-        }
-
-        if (!root)
-            return false;
-
-        bool found = false;
-
-        for (int j = 0; j < root->childCount(); ++j)
-        {
-            if (element.compare(root->child(j)->text(0), cs) == 0)
-            {
-                root = root->child(j);
-                found = true;
-                break;
-            }
-        }
-
-        if (!found)
-        {
-            root = new QTreeWidgetItem(root);
-            root->setText(0, element);
-            root->setIcon(0, QIcon(":/images/folder.png"));
-        }
-    }
-
-    QTreeWidgetItem* objectItem = new QTreeWidgetItem(root);
-    objectItem->setText(0, name);
-    objectItem->setText(1, realPath.isEmpty() ? path : realPath);
-    objectItem->setToolTip(1, objectItem->text(1));
-    objectItem->setIcon(0, QIcon(":/images/module.png"));
-
-    addSymbols(compiland, objectItem);
-    addSourceFiles(compiland, objectItem);
-
-    return true;
-}
-
-void MainWindow::addSymbols(IDiaSymbol* compiland, QTreeWidgetItem* parent)
-{
-    QTreeWidgetItem* typedefsItem = new QTreeWidgetItem();
-    QVector<IDiaSymbol*> typedefs = QDIA::findChildren(compiland, SymTagTypedef);
-    for (int i = 0; i < typedefs.size(); ++i)
-    {
-        addTypedef(typedefs.at(i), typedefsItem);
-        typedefs.at(i)->Release();
-    }
-    if (typedefsItem->childCount() > 0)
-    {
-        parent->addChild(typedefsItem);
-        typedefsItem->setText(0, QStringLiteral("Typedefs (%1)").arg(typedefsItem->childCount()));
-        typedefsItem->setIcon(0, QIcon(":/images/database_green.png"));
-    }
-    else
-    {
-        delete typedefsItem;
-    }
-
-    QTreeWidgetItem* functionsItem = new QTreeWidgetItem();
-    addSymbolFunctions(compiland, functionsItem);
-    if (functionsItem->childCount() > 0)
-    {
-        parent->addChild(functionsItem);
-        functionsItem->setText(0, QStringLiteral("Functions (%1)").arg(functionsItem->childCount()));
-        functionsItem->setIcon(0, QIcon(":/images/math_functions.png"));
-    }
-    else
-    {
-        delete functionsItem;
-    }
-}
-
-void MainWindow::addSourceFiles(IDiaSymbol* compiland, QTreeWidgetItem* parent)
-{
-    QTreeWidgetItem* filesItem = new QTreeWidgetItem();
-
-    QVector<IDiaSourceFile*> files = QDIA::findSourceFiles(_diaSession, compiland);
-    for (int j = 0; j < files.size(); ++j)
-    {
-        IDiaSourceFile* file = files.at(j);
-        QString filePath = QDIA::getFileName(file);
-        file->Release();
-        QString fileName;
-        int slash = qMax(filePath.lastIndexOf('/'), filePath.lastIndexOf('\\'));
-        fileName = (slash >= 0) ? filePath.mid(slash + 1) : filePath;
-        QTreeWidgetItem* item = new QTreeWidgetItem(filesItem);
-        item->setText(0, fileName);
-        item->setText(1, filePath);
-        item->setIcon(0, QIcon(":/images/source_code.png"));
-    }
-
-    if (filesItem->childCount() > 0)
-    {
-        parent->addChild(filesItem);
-        filesItem->setText(0, QStringLiteral("Source Code (%1)").arg(filesItem->childCount()));
-        filesItem->setIcon(0, QIcon(":/images/folder_page.png"));
-    }
-    else
-    {
-        delete filesItem;
-    }
-}
-
-void MainWindow::addTypedef(IDiaSymbol* symbol, QTreeWidgetItem* parent)
-{
-    QString name = QDIA::getName(symbol);
-    QString type = QDIA::getTypeInformation(symbol);
-
-    QTreeWidget* treeWidget = _treeTypedefs;
-    QTreeWidgetItem* item = nullptr;
-    if (parent)
-    {
-        item = new QTreeWidgetItem();
-        parent->addChild(item);
-    }
-    else
-    {
-        int position = treeWidget->topLevelItemCount();
-
-        for (int i = 0; i < treeWidget->topLevelItemCount(); ++i)
-        {
-            item = treeWidget->topLevelItem(i);
-
-            if (name > item->text(1))
-                continue;
-
-            if (name == item->text(1) && type == item->text(0))
-                return;
-
-            position = i;
-            break;
-        }
-
-        item = new QTreeWidgetItem();
-        treeWidget->insertTopLevelItem(position, item);
-    }
-    item->setText(0, type);
-    item->setText(1, name);
-    item->setIcon(0, QIcon(":/images/token_lookaround.png"));
-
-}
-
-void MainWindow::addEnum(IDiaSymbol* symbol, QTreeWidgetItem* parent)
-{
-    QString name = QDIA::getName(symbol);
-    QString type = QDIA::getTypeInformation(symbol);
-
-    if (type == QStringLiteral("int"))
-        type.clear();
-
-    QTreeWidget* treeWidget = _treeEnums;
-    QTreeWidgetItem* item = nullptr;
-    if (parent)
-    {
-        item = new QTreeWidgetItem();
-        parent->addChild(item);
-    }
-    else
-    {
-        int position = treeWidget->topLevelItemCount();
-
-        for (int i = 0; i < treeWidget->topLevelItemCount(); ++i)
-        {
-            item = treeWidget->topLevelItem(i);
-
-            if (name > item->text(0))
-                continue;
-
-            position = i;
-            break;
-        }
-
-        item = new QTreeWidgetItem();
-        treeWidget->insertTopLevelItem(position, item);
-    }
-    item->setText(0, name);
-    item->setText(1, type);
-    item->setIcon(0, QIcon(":/images/text_list_numbers.png"));
-
-    QVector<IDiaSymbol*> data = QDIA::findChildren(symbol, SymTagData);
-    for (int i = 0; i < data.size(); ++i)
-    {
-        IDiaSymbol* entity = data.at(i);
-        QTreeWidgetItem* subitem = new QTreeWidgetItem(item);
-        subitem->setText(0, QDIA::getName(entity));
-        subitem->setText(1, QDIA::getValue(entity).toString());
-        subitem->setIcon(0, QIcon(":/images/bullet_black.png"));
-        entity->Release();
-    }
-}
-
-void MainWindow::addUserType(IDiaSymbol* symbol, QTreeWidgetItem* parent)
-{
-    QString kind = QDIA::getUdtKind(symbol);
-    QString name = kind + QLatin1Char(' ') + QDIA::getName(symbol);
-    QString type = QDIA::getTypeInformation(symbol);
-
-    QTreeWidget* treeWidget = _treeUserTypes;
-    QTreeWidgetItem* item = nullptr;
-    if (parent)
-    {
-        item = new QTreeWidgetItem();
-        parent->addChild(item);
-    }
-    else
-    {
-        int position = treeWidget->topLevelItemCount();
-
-        for (int i = 0; i < treeWidget->topLevelItemCount(); ++i)
-        {
-            item = treeWidget->topLevelItem(i);
-
-            if (name > item->text(0))
-                continue;
-
-            position = i;
-            break;
-        }
-
-        item = new QTreeWidgetItem();
-        treeWidget->insertTopLevelItem(position, item);
-    }
-    item->setText(0, name);
-    item->setText(1, type);
-    if (kind == QStringLiteral("class"))
-    {
-        item->setIcon(0, QIcon(":/images/bricks.png"));
-    }
-    else if (kind == QStringLiteral("struct"))
-    {
-        item->setIcon(0, QIcon(":/images/bricks_struct.png"));
-    }
-    else if (kind == QStringLiteral("union"))
-    {
-        item->setIcon(0, QIcon(":/images/token_group.png"));
-    }
-    else
-    {
-        item->setIcon(0, QIcon(":/images/token_match_character_literally.png"));
-    }
-
-    QVector<IDiaSymbol*> data = QDIA::findChildren(symbol, SymTagData);
-    for (int i = 0; i < data.size(); ++i)
-    {
-        IDiaSymbol* entity = data.at(i);
-        QTreeWidgetItem* subitem = new QTreeWidgetItem(item);
-        subitem->setText(0, QDIA::getTypeInformation(entity) + QLatin1Char(' ') + QDIA::getName(entity));
-        subitem->setText(1, QDIA::getValue(entity).toString());
-        subitem->setIcon(0, QIcon(":/images/bullet_black.png"));
-        entity->Release();
-    }
-}
-
-void MainWindow::addSymbolFunctions(IDiaSymbol* compiland, QTreeWidgetItem* parent)
-{
-    auto functions = QDIA::findChildren(compiland, SymTagFunction);
-    for (int i = 0; i < functions.count(); ++i)
-    {
-        IDiaSymbol* function = functions.at(i);
-        QTreeWidgetItem* functionItem = new QTreeWidgetItem(parent);
-        functionItem->setText(0, QDIA::getUndName(function));
-        functionItem->setIcon(0, QIcon(":/images/function.png"));
-        function->Release();
-    }
+    return _objectDirectories.insert(pathTree, index);
 }
@@ -52,18 +52,28 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QScopedPointer>
 
-#include "qdia.h"
+#include "addressresolver.h"
+#include "directorytrie.h"
+#include "symboldatabase.h"
+#include "symbolloader.h"
+#include "symbolprovider.h"
+#include "symbolstore.h"
 
 class MdiChild;
 class Path;
+class SymbolTreeModel;
 
 class QAction;
+class QLineEdit;
 class QMenu;
 class QMdiArea;
 class QMdiSubWindow;
-class QTreeWidget;
-class QTreeWidgetItem;
+class QPlainTextEdit;
+class QProgressBar;
+class QPushButton;
+class QTreeView;
 
 
 class MainWindow : public QMainWindow
@@ -73,7 +83,10 @@ class MainWindow : public QMainWindow
 public:
     MainWindow();
 
-    bool openFile(const QString &fileName);
+    // A non-empty filter loads only the symbols whose name matches it
+    bool openFile(const QString &fileName, const SymbolFilter& filter = SymbolFilter());
+    // Takes ownership of an already opened provider
+    bool openProvider(SymbolProvider* provider, const QString& fileName);
     void closeFile();
 
 protected:
@@ -81,6 +94,7 @@ protected:
 
 private slots:
     void open();
+    void openFiltered();
     void save();
     void saveAs();
     void updateRecentFileActions();
@@ -90,13 +104,24 @@ private slots:
     void paste();
     void updateMenus();
     void updateWindowMenu();
+    void resolveAddresses();
+    void editSymbolStores();
+    void rebuildSymbolIndex();
+    void cancelLoad();
+    void loadProgress(int phase, int done, int total);
+    void modulesLoaded(const QVector<SymbolModule>& modules);
+    void typedefsLoaded(const QVector<SymbolTypedef>& typedefs);
+    void enumsLoaded(const QVector<SymbolEnum>& enums);
+    void userTypesLoaded(const QVector<SymbolUserType>& userTypes);
+    void loadFinished(bool completed);
     MdiChild *createMdiChild();
 
 private:
     enum { MaxRecentFiles = 5 };
 
-    void createDockedTree(QTreeWidget** widget, const QString& name,
-                          const QStringList& header = QStringList());
+    void createDockedTree(QTreeView** view, SymbolTreeModel** model, const QString& name,
+                          const QStringList& header);
+    void createAddressDock();
     void createActions();
     void createStatusBar();
     void readSettings();
@@ -107,19 +132,13 @@ private:
     MdiChild *activeMdiChild() const;
     QMdiSubWindow *findMdiChild(const QString &fileName) const;
 
-    void readModules();
+    void readModules(int first);
     void readSourceFiles();
     void readTypedefs();
     void readEnums();
     void readUserTypes();
-    void addModule(IDiaSymbol* compiland);
-    bool addObject(IDiaSymbol* compiland);
-    void addSymbols(IDiaSymbol* compiland, QTreeWidgetItem* parent);
-    void addSourceFiles(IDiaSymbol* compiland, QTreeWidgetItem* parent);
-    void addTypedef(IDiaSymbol* symbol, QTreeWidgetItem* parent);
-    void addEnum(IDiaSymbol* symbol, QTreeWidgetItem* parent);
-    void addUserType(IDiaSymbol* symbol, QTreeWidgetItem* parent);
-    void addSymbolFunctions(IDiaSymbol* compiland, QTreeWidgetItem* parent);
+    void addModule(int index);
+    bool addObject(int index);
 
 private:
     QMdiArea *mdiArea;
@@ -142,19 +161,31 @@ private:
     QAction *previousAct;
     QAction *windowMenuSeparatorAct;
 
-    QTreeWidget* _treeModules;
-    QTreeWidget* _treeObjects;
-    QTreeWidget* _treeSources;
-    QTreeWidget* _treeTest;
-    QTreeWidget* _treeTypedefs;
-    QTreeWidget* _treeEnums;
-    QTreeWidget* _treeUserTypes;
+    QTreeView* _treeModules;
+    QTreeView* _treeObjects;
+    QTreeView* _treeTypedefs;
+    QTreeView* _treeEnums;
+    QTreeView* _treeUserTypes;
+    SymbolTreeModel* _modelModules;
+    SymbolTreeModel* _modelObjects;
+    SymbolTreeModel* _modelTypedefs;
+    SymbolTreeModel* _modelEnums;
+    SymbolTreeModel* _modelUserTypes;
+    QLineEdit* _addressBase;
+    QPlainTextEdit* _addressInput;
+    QProgressBar* _loadProgress;
+    QPushButton* _loadCancel;
+    int _objectCount;
+    QVector<int> _libraryNodes;
 
 private:
-    HMODULE _library;
-    IDiaDataSource* _diaDataSource;
-    IDiaSession* _diaSession;
-    IDiaSymbol* _diaSymbolGlobal;
+    QScopedPointer<SymbolProvider> _provider;
+    SymbolDatabase _symbols;
+    AddressResolver _resolver;
+    SymbolStore _symbolStore;
+    DirectoryTrie _objectDirectories;
+    // Last, so that a running load is stopped before the provider goes away
+    SymbolLoader _loader;
 };
 
 #endif
@@ -0,0 +1,229 @@
+#include "msf.h"
+
+#include <QtEndian>
+
+#include <cstring>
+
+
+static const char s_msfMagic[] = "Microsoft C/C++ MSF 7.00\r\n\x1a" "DS\0\0";
+static const int s_msfMagicSize = 32;
+
+static inline quint32 blocksFor(quint32 size, quint32 blockSize)
+{
+    return (size + blockSize - 1) / blockSize;
+}
+
+MsfFile::MsfFile()
+    : _data(nullptr)
+    , _size(0)
+    , _blockSize(0)
+    , _blockCount(0)
+    , _directorySize(0)
+    , _directoryMapBlock(0)
+{
+}
+
+MsfFile::~MsfFile()
+{
+    close();
+}
+
+bool MsfFile::open(const QString& fileName)
+{
+    close();
+
+    _file.setFileName(fileName);
+    if (!_file.open(QIODevice::ReadOnly))
+        return false;
+
+    _size = _file.size();
+    if (_size >= s_msfMagicSize + 24)
+        _data = _file.map(0, _size);
+
+    if (!_data || !readSuperBlock() || !readDirectory())
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void MsfFile::close()
+{
+    if (_data)
+        _file.unmap(const_cast<uchar*>(_data));
+
+    _file.close();
+    _data = nullptr;
+    _size = 0;
+    _blockSize = 0;
+    _blockCount = 0;
+    _directorySize = 0;
+    _directoryMapBlock = 0;
+    _streamSizes.clear();
+    _streamFirstBlock.clear();
+    _blocks.clear();
+}
+
+bool MsfFile::isContiguous(int index) const
+{
+    if (index < 0 || index >= _streamSizes.size())
+        return false;
+
+    const quint32* blocks = _blocks.constData() + _streamFirstBlock.at(index);
+    quint32 count = blocksFor(_streamSizes.at(index), _blockSize);
+
+    for (quint32 i = 1; i < count; ++i)
+    {
+        if (blocks[i] != blocks[i - 1] + 1)
+            return false;
+    }
+
+    return true;
+}
+
+QByteArray MsfFile::stream(int index) const
+{
+    return stream(index, NilStreamSize);
+}
+
+QByteArray MsfFile::stream(int index, quint32 maxSize) const
+{
+    if (index < 0 || index >= _streamSizes.size())
+        return QByteArray();
+
+    quint32 size = qMin(_streamSizes.at(index), maxSize);
+    if (size == 0)
+        return QByteArray();
+
+    // A prefix that fits in the first block never needs gathering
+    const quint32* blocks = _blocks.constData() + _streamFirstBlock.at(index);
+    if (size <= _blockSize || isContiguous(index))
+    {
+        return QByteArray::fromRawData(reinterpret_cast<const char*>(_data) +
+                                       qint64(blocks[0]) * _blockSize, int(size));
+    }
+
+    return gather(blocks, size);
+}
+
+bool MsfFile::readSuperBlock()
+{
+    if (memcmp(_data, s_msfMagic, s_msfMagicSize) != 0)
+        return false;
+
+    const uchar* header = _data + s_msfMagicSize;
+    _blockSize = qFromLittleEndian<quint32>(header);
+    _blockCount = qFromLittleEndian<quint32>(header + 8);
+    _directorySize = qFromLittleEndian<quint32>(header + 12);
+    _directoryMapBlock = qFromLittleEndian<quint32>(header + 20);
+
+    switch (_blockSize)
+    {
+    case 512:
+    case 1024:
+    case 2048:
+    case 4096:
+        break;
+    default:
+        return false;
+    }
+
+    if (qint64(_blockCount) * _blockSize > _size)
+        return false;
+
+    if (_directoryMapBlock >= _blockCount || _directorySize < 4)
+        return false;
+
+    // The directory block list has to fit into the single map block
+    return (blocksFor(_directorySize, _blockSize) * 4 <= _blockSize);
+}
+
+bool MsfFile::readDirectory()
+{
+    quint32 directoryBlockCount = blocksFor(_directorySize, _blockSize);
+
+    QVector<quint32> directoryBlocks(directoryBlockCount);
+    const uchar* map = _data + qint64(_directoryMapBlock) * _blockSize;
+    for (quint32 i = 0; i < directoryBlockCount; ++i)
+        directoryBlocks[i] = qFromLittleEndian<quint32>(map + i * 4);
+
+    if (!validBlocks(directoryBlocks.constData(), directoryBlockCount))
+        return false;
+
+    QByteArray directory = gather(directoryBlocks.constData(), _directorySize);
+    const uchar* data = reinterpret_cast<const uchar*>(directory.constData());
+    const uchar* end = data + directory.size();
+
+    quint32 streamCount = qFromLittleEndian<quint32>(data);
+    data += 4;
+
+    if (quint64(streamCount) * 4 > quint64(end - data))
+        return false;
+
+    _streamSizes.resize(streamCount);
+    _streamFirstBlock.resize(streamCount);
+
+    quint64 totalBlocks = 0;
+    for (quint32 i = 0; i < streamCount; ++i)
+    {
+        quint32 size = qFromLittleEndian<quint32>(data);
+        data += 4;
+
+        if (size == NilStreamSize)
+            size = 0;
+
+        _streamSizes[i] = size;
+        totalBlocks += blocksFor(size, _blockSize);
+    }
+
+    if (totalBlocks * 4 > quint64(end - data))
+        return false;
+
+    _blocks.resize(int(totalBlocks));
+    for (quint32 i = 0; i < totalBlocks; ++i)
+        _blocks[i] = qFromLittleEndian<quint32>(data + i * 4);
+
+    if (!validBlocks(_blocks.constData(), quint32(totalBlocks)))
+        return false;
+
+    int first = 0;
+    for (quint32 i = 0; i < streamCount; ++i)
+    {
+        _streamFirstBlock[i] = first;
+        first += blocksFor(_streamSizes.at(i), _blockSize);
+    }
+
+    return true;
+}
+
+bool MsfFile::validBlocks(const quint32* blocks, quint32 count) const
+{
+    for (quint32 i = 0; i < count; ++i)
+    {
+        if (blocks[i] >= _blockCount)
+            return false;
+    }
+
+    return true;
+}
+
+QByteArray MsfFile::gather(const quint32* blocks, quint32 size) const
+{
+    QByteArray result;
+    result.resize(int(size));
+
+    char* output = result.data();
+    quint32 remaining = size;
+
+    for (quint32 i = 0; remaining > 0; ++i)
+    {
+        quint32 chunk = qMin(remaining, _blockSize);
+        memcpy(output, _data + qint64(blocks[i]) * _blockSize, chunk);
+        output += chunk;
+        remaining -= chunk;
+    }
+
+    return result;
+}
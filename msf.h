@@ -0,0 +1,88 @@
+#ifndef MSF_H
+#define MSF_H
+
+
+#include <QByteArray>
+#include <QFile>
+#include <QVector>
+
+
+class MsfFile
+{
+public:
+    enum { NilStreamSize = 0xFFFFFFFF };
+
+public:
+    MsfFile();
+    ~MsfFile();
+
+    bool open(const QString& fileName);
+    void close();
+    bool isOpen() const;
+
+    QString fileName() const;
+    quint32 blockSize() const;
+    quint32 blockCount() const;
+
+    int streamCount() const;
+    quint32 streamSize(int index) const;
+    bool isContiguous(int index) const;
+
+    // Returns a view into the mapped file when the stream's blocks are
+    // contiguous and a gathered copy otherwise. Views stay valid until close().
+    // The second overload returns at most the first maxSize bytes.
+    QByteArray stream(int index) const;
+    QByteArray stream(int index, quint32 maxSize) const;
+
+private:
+    bool readSuperBlock();
+    bool readDirectory();
+    bool validBlocks(const quint32* blocks, quint32 count) const;
+    QByteArray gather(const quint32* blocks, quint32 size) const;
+
+private:
+    QFile _file;
+    const uchar* _data;
+    qint64 _size;
+    quint32 _blockSize;
+    quint32 _blockCount;
+    quint32 _directorySize;
+    quint32 _directoryMapBlock;
+    QVector<quint32> _streamSizes;
+    QVector<int> _streamFirstBlock;
+    QVector<quint32> _blocks;
+};
+
+
+inline bool MsfFile::isOpen() const
+{
+    return (_data != nullptr);
+}
+
+inline QString MsfFile::fileName() const
+{
+    return _file.fileName();
+}
+
+inline quint32 MsfFile::blockSize() const
+{
+    return _blockSize;
+}
+
+inline quint32 MsfFile::blockCount() const
+{
+    return _blockCount;
+}
+
+inline int MsfFile::streamCount() const
+{
+    return _streamSizes.size();
+}
+
+inline quint32 MsfFile::streamSize(int index) const
+{
+    return (index >= 0 && index < _streamSizes.size()) ? _streamSizes.at(index) : 0;
+}
+
+
+#endif // MSF_H
@@ -0,0 +1,503 @@
+#include "nativesymbolprovider.h"
+
+#include "codeview.h"
+
+#include <algorithm>
+
+
+NativeSymbolProvider::NativeSymbolProvider()
+{
+}
+
+bool NativeSymbolProvider::open(const QString& fileName)
+{
+    return _pdb.open(fileName);
+}
+
+void NativeSymbolProvider::close()
+{
+    _pdb.close();
+    _atoms.clear();
+}
+
+QVector<SymbolCompiland> NativeSymbolProvider::compilands()
+{
+    const PdbDbiStream& dbi = _pdb.dbi();
+
+    QVector<SymbolCompiland> result;
+    result.reserve(dbi.moduleCount());
+
+    for (int i = 0; i < dbi.moduleCount(); ++i)
+    {
+        SymbolCompiland compiland;
+        compiland.id = quint32(i);
+        compiland.name = dbi.moduleName(i);
+        compiland.libraryName = dbi.libraryName(i);
+        compiland.objectPath = _pdb.buildInfo(i).objectPath;
+        result.append(compiland);
+    }
+
+    return result;
+}
+
+QVector<SymbolSourceFile> NativeSymbolProvider::sourceFiles(quint32 compiland)
+{
+    QVector<quint32> files = _pdb.moduleFiles(int(compiland));
+
+    QVector<SymbolSourceFile> result;
+    result.reserve(files.size());
+
+    for (int i = 0; i < files.size(); ++i)
+    {
+        SymbolSourceFile file = { files.at(i), _pdb.strings().string(files.at(i)) };
+        result.append(file);
+    }
+
+    return result;
+}
+
+bool NativeSymbolProvider::visitTypedefs(quint32 scope, const Visitor<SymbolTypedef>& visitor)
+{
+    quint32 compareFlags = 0;
+    QString name = searchName(&compareFlags);
+
+    if (scope == GlobalScope && !name.isEmpty())
+    {
+        const QVector<CvSymbol> symbols = _pdb.findChildren(SymTagTypedef, name, compareFlags);
+        for (int i = 0; i < symbols.size(); ++i)
+        {
+            SymbolTypedef item;
+            if (readTypedef(symbols.at(i), &item) && !visitor(item))
+                return false;
+        }
+        return true;
+    }
+
+    if (scope == GlobalScope)
+        return readTypedefs(_pdb.globalSymbols(), visitor);
+
+    return readTypedefs(_pdb.moduleSymbols(int(scope)), visitor);
+}
+
+bool NativeSymbolProvider::visitEnums(const Visitor<SymbolEnum>& visitor)
+{
+    const PdbTypeStream& types = _pdb.types();
+
+    for (quint32 ti = types.typeIndexBegin(); ti < types.typeIndexEnd(); ++ti)
+    {
+        if (isCancelled())
+            return false;
+
+        PdbTypeRecord type = types.record(ti);
+        if (type.kind != LF_ENUM)
+            continue;
+
+        CvReader reader(type.data, type.end());
+        reader.skip(2);
+        quint16 property = reader.read16();
+        quint32 underlying = reader.read32();
+        quint32 fieldList = reader.read32();
+
+        if (property & CV_PROP_FWDREF)
+            continue;
+
+        QString name = reader.readString();
+        if (!filter().matches(name))
+            continue;
+
+        SymbolEnum item;
+        item.name = _atoms.intern(name);
+        item.type = types.typeName(underlying);
+        item.values = readMembers(fieldList, true);
+        if (!visitor(item))
+            return false;
+    }
+
+    return true;
+}
+
+bool NativeSymbolProvider::visitUserTypes(const Visitor<SymbolUserType>& visitor)
+{
+    const PdbTypeStream& types = _pdb.types();
+
+    for (quint32 ti = types.typeIndexBegin(); ti < types.typeIndexEnd(); ++ti)
+    {
+        if (isCancelled())
+            return false;
+
+        PdbTypeRecord type = types.record(ti);
+
+        SymbolUserType item;
+        switch (type.kind)
+        {
+        case LF_CLASS:
+            item.kind = QStringLiteral("class");
+            break;
+        case LF_STRUCTURE:
+            item.kind = QStringLiteral("struct");
+            break;
+        case LF_UNION:
+            item.kind = QStringLiteral("union");
+            break;
+        case LF_INTERFACE:
+            item.kind = QStringLiteral("interface");
+            break;
+        default:
+            continue;
+        }
+
+        CvReader reader(type.data, type.end());
+        reader.skip(2);
+        quint16 property = reader.read16();
+        quint32 fieldList = reader.read32();
+
+        if (property & CV_PROP_FWDREF)
+            continue;
+
+        QString name = types.recordName(type);
+        if (!filter().matches(name))
+            continue;
+
+        item.name = _atoms.intern(name);
+        item.members = readMembers(fieldList, false);
+        if (!visitor(item))
+            return false;
+    }
+
+    return true;
+}
+
+bool NativeSymbolProvider::visitFunctions(quint32 compiland, const Visitor<SymbolFunction>& visitor)
+{
+    quint32 compareFlags = 0;
+    QString name = searchName(&compareFlags);
+    CvSymbol symbol;
+
+    if (!name.isEmpty())
+    {
+        // Procedure references name the module and the offset of the procedure in it
+        const QVector<CvSymbol> references = _pdb.findChildren(SymTagFunction, name, compareFlags);
+        CvSymbolIterator symbols;
+        bool loaded = false;
+
+        for (int i = 0; i < references.size(); ++i)
+        {
+            CvReader reader(references.at(i).data, references.at(i).end());
+            reader.skip(4);
+            quint32 offset = reader.read32();
+            quint16 module = reader.read16();
+            if (!reader.isValid() || module != compiland + 1)
+                continue;
+
+            // Modules without a match never have their stream read
+            if (!loaded)
+            {
+                symbols = _pdb.moduleSymbols(int(compiland));
+                loaded = true;
+            }
+
+            CvProcedure procedure;
+            if (!symbols.seek(offset) || !symbols.next(&symbol) ||
+                !CvSymbolIterator::readProcedure(symbol, &procedure))
+            {
+                continue;
+            }
+
+            SymbolFunction function;
+            function.name = _atoms.internUtf8(procedure.name, procedure.nameSize);
+            function.rva = _pdb.rva(procedure.segment, procedure.offset);
+            if (!visitor(function))
+                return false;
+        }
+
+        return true;
+    }
+
+    CvSymbolIterator symbols = _pdb.moduleSymbols(int(compiland));
+
+    while (symbols.next(&symbol))
+    {
+        if (isCancelled())
+            return false;
+
+        CvProcedure procedure;
+        if (CvSymbolIterator::readProcedure(symbol, &procedure))
+        {
+            SymbolFunction function;
+            if (internFiltered(procedure.name, procedure.nameSize, &function.name))
+            {
+                function.rva = _pdb.rva(procedure.segment, procedure.offset);
+                if (!visitor(function))
+                    return false;
+            }
+        }
+
+        // Nested blocks and inlinees are not functions of the compiland
+        if (CvSymbolIterator::opensScope(symbol.kind) && !symbols.skipScope(symbol))
+            break;
+    }
+
+    return true;
+}
+
+bool NativeSymbolProvider::sectionContributions(ContributionIndex* index)
+{
+    *index = _pdb.contributions();
+    return !index->isEmpty();
+}
+
+bool NativeSymbolProvider::findFunction(quint32 rva, SymbolRange* result)
+{
+    int module = _pdb.findModule(rva);
+    if (module < 0)
+        return false;
+
+    CvSymbolIterator symbols = _pdb.moduleSymbols(module);
+    CvSymbol symbol;
+    bool found = false;
+
+    while (!found && symbols.next(&symbol))
+    {
+        CvProcedure procedure;
+        if (CvSymbolIterator::readProcedure(symbol, &procedure))
+        {
+            quint32 begin = _pdb.rva(procedure.segment, procedure.offset);
+            if (rva >= begin && rva - begin < procedure.length)
+            {
+                result->rva = begin;
+                result->size = procedure.length;
+                result->name = _atoms.internUtf8(procedure.name, procedure.nameSize);
+                found = true;
+            }
+        }
+
+        if (!found && CvSymbolIterator::opensScope(symbol.kind) && !symbols.skipScope(symbol))
+            break;
+    }
+
+    if (!found)
+        return false;
+
+    return findLines(result->rva, result->size, &result->lines);
+}
+
+bool NativeSymbolProvider::findLines(quint32 rva, quint32 size, QVector<SymbolLine>* lines)
+{
+    lines->clear();
+
+    QSharedPointer<const PdbLineTable> table = _pdb.lineTable(_pdb.findModule(rva));
+    if (!table)
+        return false;
+
+    PdbLine line;
+    quint32 address = rva;
+
+    while (address - rva < size && table->findLine(address, &line) && line.length > 0)
+    {
+        SymbolLine item = { line.rva, line.length, line.line, _pdb.strings().string(line.fileId) };
+        lines->append(item);
+        address = line.rva + line.length;
+    }
+
+    return true;
+}
+
+bool NativeSymbolProvider::visitAddresses(const Visitor<SymbolAddress>& visitor)
+{
+    QVector<SymbolAddress> addresses;
+    CvSymbol symbol;
+
+    // Publics and global data live in the global stream, procedures only in the modules
+    CvSymbolIterator globals = _pdb.globalSymbols();
+    while (globals.next(&symbol))
+    {
+        SymbolAddress address;
+        switch (symbol.kind)
+        {
+        case S_PUB32:
+            address.kind = SymbolAddress::Public;
+            break;
+        case S_GDATA32:
+        case S_LDATA32:
+            address.kind = SymbolAddress::Data;
+            break;
+        default:
+            continue;
+        }
+
+        CvReader reader(symbol.data, symbol.end());
+        reader.skip(4);
+        quint32 offset = reader.read32();
+        quint16 segment = reader.read16();
+
+        QString name = reader.readString();
+        if (!filter().matches(name))
+            continue;
+
+        address.rva = _pdb.rva(segment, offset);
+        address.length = 0;
+        address.name = _atoms.intern(name);
+        if (address.rva)
+            addresses.append(address);
+    }
+
+    for (int module = 0; module < _pdb.dbi().moduleCount(); ++module)
+    {
+        if (isCancelled())
+            return false;
+
+        CvSymbolIterator symbols = _pdb.moduleSymbols(module);
+        while (symbols.next(&symbol))
+        {
+            CvProcedure procedure;
+            QString name;
+            if (CvSymbolIterator::readProcedure(symbol, &procedure) &&
+                internFiltered(procedure.name, procedure.nameSize, &name))
+            {
+                SymbolAddress address = { _pdb.rva(procedure.segment, procedure.offset), procedure.length,
+                                          SymbolAddress::Function, name };
+                addresses.append(address);
+            }
+
+            if (CvSymbolIterator::opensScope(symbol.kind) && !symbols.skipScope(symbol))
+                break;
+        }
+    }
+
+    // The streams are in record order, a stable sort keeps publics ahead of their functions
+    std::stable_sort(addresses.begin(), addresses.end(),
+                     [](const SymbolAddress& left, const SymbolAddress& right) { return left.rva < right.rva; });
+
+    for (int i = 0; i < addresses.size(); ++i)
+    {
+        if (isCancelled() || !visitor(addresses.at(i)))
+            return false;
+    }
+
+    return true;
+}
+
+QString NativeSymbolProvider::statistics() const
+{
+    return QStringLiteral("%1 names, %2 reused").arg(_atoms.count()).arg(_atoms.hits());
+}
+
+QString NativeSymbolProvider::searchName(quint32* compareFlags) const
+{
+    const SymbolFilter& filter = this->filter();
+    if (filter.isEmpty() || filter.syntax() != SymbolFilter::FixedString)
+        return QString();
+
+    *compareFlags = (filter.caseSensitivity() == Qt::CaseInsensitive) ? PdbFile::SearchCaseInsensitive
+                                                                      : PdbFile::SearchCaseSensitive;
+    return filter.pattern();
+}
+
+bool NativeSymbolProvider::readTypedefs(CvSymbolIterator symbols, const Visitor<SymbolTypedef>& visitor)
+{
+    CvSymbol symbol;
+
+    while (symbols.next(&symbol))
+    {
+        if (isCancelled())
+            return false;
+
+        if (CvSymbolIterator::opensScope(symbol.kind))
+        {
+            if (!symbols.skipScope(symbol))
+                break;
+            continue;
+        }
+
+        SymbolTypedef item;
+        if (readTypedef(symbol, &item) && !visitor(item))
+            return false;
+    }
+
+    return true;
+}
+
+bool NativeSymbolProvider::readTypedef(const CvSymbol& symbol, SymbolTypedef* result)
+{
+    if (symbol.kind != S_UDT)
+        return false;
+
+    const PdbTypeStream& types = _pdb.types();
+    CvReader reader(symbol.data, symbol.end());
+    quint32 typeIndex = reader.read32();
+    QString name = reader.readString();
+
+    // A UDT record naming a class or enum after itself declares the type, not an alias
+    PdbTypeRecord type = types.record(typeIndex);
+    switch (type.kind)
+    {
+    case LF_CLASS:
+    case LF_STRUCTURE:
+    case LF_UNION:
+    case LF_INTERFACE:
+    case LF_ENUM:
+        if (types.recordName(type) == name)
+            return false;
+        break;
+    default:
+        break;
+    }
+
+    if (!filter().matches(name))
+        return false;
+
+    result->name = _atoms.intern(name);
+    result->type = types.typeName(typeIndex);
+    return true;
+}
+
+QVector<SymbolMember> NativeSymbolProvider::readMembers(quint32 fieldList, bool enumerators)
+{
+    const PdbTypeStream& types = _pdb.types();
+    QVector<PdbField> fields = types.fields(fieldList);
+
+    QVector<SymbolMember> result;
+    result.reserve(fields.size());
+
+    for (int i = 0; i < fields.size(); ++i)
+    {
+        const PdbField& field = fields.at(i);
+
+        SymbolMember member;
+        member.name = _atoms.intern(field.name);
+
+        if (enumerators)
+        {
+            if (field.kind != LF_ENUMERATE)
+                continue;
+            member.value = QString::number(qint64(field.value));
+        }
+        else
+        {
+            if (field.kind == LF_ENUMERATE)
+                continue;
+            member.type = types.typeName(field.typeIndex);
+        }
+
+        result.append(member);
+    }
+
+    return result;
+}
+
+bool NativeSymbolProvider::internFiltered(const char* name, int size, QString* result)
+{
+    if (filter().isEmpty())
+    {
+        *result = _atoms.internUtf8(name, size);
+        return true;
+    }
+
+    // Names that do not pass the filter never reach the atom table
+    QString decoded = QString::fromUtf8(name, size);
+    if (!filter().matches(decoded))
+        return false;
+
+    *result = _atoms.intern(decoded);
+    return true;
+}
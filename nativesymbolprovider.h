@@ -0,0 +1,53 @@
+#ifndef NATIVESYMBOLPROVIDER_H
+#define NATIVESYMBOLPROVIDER_H
+
+
+#include "atomtable.h"
+#include "pdbfile.h"
+#include "symbolprovider.h"
+
+
+// Reads a PDB directly without DIA, compiland ids are DBI module indices
+class NativeSymbolProvider : public SymbolProvider
+{
+public:
+    NativeSymbolProvider();
+
+    bool open(const QString& fileName) override;
+    void close() override;
+
+    QVector<SymbolCompiland> compilands() override;
+    QVector<SymbolSourceFile> sourceFiles(quint32 compiland) override;
+    bool visitTypedefs(quint32 scope, const Visitor<SymbolTypedef>& visitor) override;
+    bool visitEnums(const Visitor<SymbolEnum>& visitor) override;
+    bool visitUserTypes(const Visitor<SymbolUserType>& visitor) override;
+    bool visitFunctions(quint32 compiland, const Visitor<SymbolFunction>& visitor) override;
+    bool sectionContributions(ContributionIndex* index) override;
+    bool findFunction(quint32 rva, SymbolRange* result) override;
+    bool findLines(quint32 rva, quint32 size, QVector<SymbolLine>* lines) override;
+    bool visitAddresses(const Visitor<SymbolAddress>& visitor) override;
+    QString statistics() const override;
+
+    const PdbFile& pdb() const;
+
+private:
+    // Fixed string filters are looked up in the PDB's name hashes instead of scanning
+    QString searchName(quint32* compareFlags) const;
+    bool readTypedefs(CvSymbolIterator symbols, const Visitor<SymbolTypedef>& visitor);
+    bool readTypedef(const CvSymbol& symbol, SymbolTypedef* result);
+    QVector<SymbolMember> readMembers(quint32 fieldList, bool enumerators);
+    bool internFiltered(const char* name, int size, QString* result);
+
+private:
+    PdbFile _pdb;
+    AtomTable _atoms;
+};
+
+
+inline const PdbFile& NativeSymbolProvider::pdb() const
+{
+    return _pdb;
+}
+
+
+#endif // NATIVESYMBOLPROVIDER_H
@@ -0,0 +1,181 @@
+#include "pdbdbi.h"
+
+#include "codeview.h"
+#include "msf.h"
+
+
+static const quint32 s_dbiVersion70 = 19990903;
+static const int s_dbiHeaderSize = 64;
+static const int s_moduleInfoSize = 64;
+static const quint32 s_contributionsVersion60 = 0xEFFE0000 + 19970605;
+static const quint32 s_contributionsVersion2 = 0xEFFE0000 + 20140516;
+
+PdbDbiStream::PdbDbiStream()
+    : _machine(0)
+    , _globalsStream(NilStreamIndex)
+    , _publicsStream(NilStreamIndex)
+    , _symbolRecordsStream(NilStreamIndex)
+    , _contributionsOffset(0)
+    , _contributionsSize(0)
+{
+}
+
+bool PdbDbiStream::load(const MsfFile& msf)
+{
+    clear();
+
+    QByteArray data = msf.stream(DbiStreamIndex);
+    if (data.size() < s_dbiHeaderSize)
+        return false;
+
+    const uchar* begin = reinterpret_cast<const uchar*>(data.constData());
+    CvReader reader(begin, begin + s_dbiHeaderSize);
+
+    qint32 signature = qint32(reader.read32());
+    quint32 version = reader.read32();
+    reader.skip(4);
+    quint16 globalsStream = reader.read16();
+    reader.skip(2);
+    quint16 publicsStream = reader.read16();
+    reader.skip(2);
+    quint16 symbolRecordsStream = reader.read16();
+    reader.skip(2);
+    qint32 moduleInfoSize = qint32(reader.read32());
+    qint32 sectionContributionSize = qint32(reader.read32());
+    qint32 sectionMapSize = qint32(reader.read32());
+    qint32 sourceInfoSize = qint32(reader.read32());
+    qint32 typeServerMapSize = qint32(reader.read32());
+    reader.skip(4);
+    qint32 debugHeaderSize = qint32(reader.read32());
+    qint32 ecSize = qint32(reader.read32());
+    reader.skip(2);
+    quint16 machine = reader.read16();
+
+    qint64 total = qint64(moduleInfoSize) + sectionContributionSize + sectionMapSize +
+                   sourceInfoSize + typeServerMapSize + ecSize + debugHeaderSize;
+
+    if (signature != -1 || version < s_dbiVersion70 || moduleInfoSize < 0 ||
+        sectionContributionSize < 0 || sectionMapSize < 0 || sourceInfoSize < 0 ||
+        typeServerMapSize < 0 || ecSize < 0 || debugHeaderSize < 0 ||
+        total > data.size() - s_dbiHeaderSize)
+    {
+        return false;
+    }
+
+    _data = data;
+    _machine = machine;
+    _globalsStream = globalsStream;
+    _publicsStream = publicsStream;
+    _symbolRecordsStream = symbolRecordsStream;
+
+    _contributionsOffset = s_dbiHeaderSize + moduleInfoSize;
+    _contributionsSize = sectionContributionSize;
+
+    int debugHeaderOffset = int(s_dbiHeaderSize + total - debugHeaderSize);
+    CvReader debugHeader(begin + debugHeaderOffset, begin + debugHeaderOffset + debugHeaderSize);
+    while (debugHeader.remaining() >= 2)
+        _debugStreams.append(debugHeader.read16());
+
+    const uchar* modules = begin + s_dbiHeaderSize;
+    if (!readModules(modules, modules + moduleInfoSize))
+    {
+        clear();
+        return false;
+    }
+
+    return true;
+}
+
+void PdbDbiStream::clear()
+{
+    _data.clear();
+    _machine = 0;
+    _globalsStream = NilStreamIndex;
+    _publicsStream = NilStreamIndex;
+    _symbolRecordsStream = NilStreamIndex;
+    _debugStreams.clear();
+    _contributionsOffset = 0;
+    _contributionsSize = 0;
+    _modules.clear();
+}
+
+QVector<PdbSectionContribution> PdbDbiStream::sectionContributions() const
+{
+    QVector<PdbSectionContribution> result;
+
+    const uchar* data = reinterpret_cast<const uchar*>(_data.constData()) + _contributionsOffset;
+    CvReader reader(data, data + _contributionsSize);
+
+    quint32 version = reader.read32();
+    int entrySize = 0;
+    if (version == s_contributionsVersion60)
+        entrySize = 28;
+    else if (version == s_contributionsVersion2)
+        entrySize = 32;
+    else
+        return result;
+
+    result.reserve(reader.remaining() / entrySize);
+    while (reader.remaining() >= entrySize)
+    {
+        CvReader entry(reader.position(), reader.position() + entrySize);
+        reader.skip(entrySize);
+
+        PdbSectionContribution contribution;
+        contribution.section = entry.read16();
+        entry.skip(2);
+        contribution.offset = entry.read32();
+        contribution.size = entry.read32();
+        contribution.characteristics = entry.read32();
+        contribution.module = entry.read16();
+        result.append(contribution);
+    }
+
+    return result;
+}
+
+bool PdbDbiStream::readModules(const uchar* data, const uchar* end)
+{
+    const uchar* begin = reinterpret_cast<const uchar*>(_data.constData());
+
+    // Module records are variable sized, a cheap upper bound avoids regrowth
+    _modules.reserve(int((end - data) / (s_moduleInfoSize + 8)));
+
+    while (end - data >= s_moduleInfoSize)
+    {
+        CvReader reader(data, end);
+        reader.skip(4 + 28 + 2);
+
+        PdbModule module;
+        module.streamIndex = reader.read16();
+        module.symbolBytes = reader.read32();
+        module.c11Bytes = reader.read32();
+        module.c13Bytes = reader.read32();
+        module.sourceFileCount = reader.read16();
+        reader.skip(2 + 4 + 4 + 4);
+
+        module.nameOffset = quint32(reader.position() - begin);
+        reader.readStringData();
+        module.libraryNameOffset = quint32(reader.position() - begin);
+        reader.readStringData();
+
+        if (!reader.isValid())
+            return false;
+
+        _modules.append(module);
+
+        int consumed = int(reader.position() - data);
+        data += (consumed + 3) & ~3;
+    }
+
+    return true;
+}
+
+QString PdbDbiStream::string(quint32 offset) const
+{
+    if (offset >= quint32(_data.size()))
+        return QString();
+
+    const char* data = _data.constData() + offset;
+    return QString::fromUtf8(data, int(qstrnlen(data, uint(_data.size()) - offset)));
+}
@@ -0,0 +1,152 @@
+#ifndef PDBDBI_H
+#define PDBDBI_H
+
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+class MsfFile;
+
+
+struct PdbModule
+{
+    quint32 nameOffset;
+    quint32 libraryNameOffset;
+    quint32 symbolBytes;
+    quint32 c11Bytes;
+    quint32 c13Bytes;
+    quint16 streamIndex;
+    quint16 sourceFileCount;
+};
+
+
+struct PdbSectionContribution
+{
+    quint16 section;
+    quint16 module;
+    quint32 offset;
+    quint32 size;
+    quint32 characteristics;
+};
+
+
+class PdbDbiStream
+{
+public:
+    enum
+    {
+        DbiStreamIndex = 3,
+        NilStreamIndex = 0xFFFF
+    };
+
+    enum DebugStream
+    {
+        DebugFpo,
+        DebugException,
+        DebugFixup,
+        DebugOmapToSource,
+        DebugOmapFromSource,
+        DebugSectionHeaders,
+        DebugTokenRidMap,
+        DebugXdata,
+        DebugPdata,
+        DebugNewFpo,
+        DebugOriginalSectionHeaders
+    };
+
+public:
+    PdbDbiStream();
+
+    bool load(const MsfFile& msf);
+    void clear();
+    bool isLoaded() const;
+
+    quint16 machine() const;
+    quint16 globalsStreamIndex() const;
+    quint16 publicsStreamIndex() const;
+    quint16 symbolRecordsStreamIndex() const;
+    quint16 debugStreamIndex(DebugStream stream) const;
+
+    int moduleCount() const;
+    const PdbModule& module(int index) const;
+    const QVector<PdbModule>& modules() const;
+    QString moduleName(int index) const;
+    QString libraryName(int index) const;
+
+    QVector<PdbSectionContribution> sectionContributions() const;
+
+private:
+    bool readModules(const uchar* data, const uchar* end);
+    QString string(quint32 offset) const;
+
+private:
+    QByteArray _data;
+    quint16 _machine;
+    quint16 _globalsStream;
+    quint16 _publicsStream;
+    quint16 _symbolRecordsStream;
+    QVector<quint16> _debugStreams;
+    int _contributionsOffset;
+    int _contributionsSize;
+    QVector<PdbModule> _modules;
+};
+
+
+inline bool PdbDbiStream::isLoaded() const
+{
+    return !_data.isEmpty();
+}
+
+inline quint16 PdbDbiStream::machine() const
+{
+    return _machine;
+}
+
+inline quint16 PdbDbiStream::globalsStreamIndex() const
+{
+    return _globalsStream;
+}
+
+inline quint16 PdbDbiStream::publicsStreamIndex() const
+{
+    return _publicsStream;
+}
+
+inline quint16 PdbDbiStream::symbolRecordsStreamIndex() const
+{
+    return _symbolRecordsStream;
+}
+
+inline quint16 PdbDbiStream::debugStreamIndex(DebugStream stream) const
+{
+    return _debugStreams.value(int(stream), NilStreamIndex);
+}
+
+inline int PdbDbiStream::moduleCount() const
+{
+    return _modules.size();
+}
+
+inline const PdbModule& PdbDbiStream::module(int index) const
+{
+    return _modules.at(index);
+}
+
+inline const QVector<PdbModule>& PdbDbiStream::modules() const
+{
+    return _modules;
+}
+
+inline QString PdbDbiStream::moduleName(int index) const
+{
+    return string(_modules.at(index).nameOffset);
+}
+
+inline QString PdbDbiStream::libraryName(int index) const
+{
+    return string(_modules.at(index).libraryNameOffset);
+}
+
+
+#endif // PDBDBI_H
@@ -0,0 +1,440 @@
+#include "pdbfile.h"
+
+#include "codeview.h"
+
+#include <climits>
+
+
+static const int s_sectionHeaderSize = 40;
+static const int s_sectionVirtualAddressOffset = 12;
+
+PdbFile::PdbFile()
+    : _age(0)
+{
+    setLineTableBudget(DefaultLineTableBudget);
+}
+
+bool PdbFile::open(const QString& fileName)
+{
+    close();
+
+    if (!_msf.open(fileName))
+        return false;
+
+    if (!loadInfoStream() || !_tpi.load(_msf, PdbTypeStream::TpiStreamIndex) || !_dbi.load(_msf))
+    {
+        close();
+        return false;
+    }
+
+    // Name lookups and addresses are optional, stripped PDBs may come without them
+    loadSectionHeaders();
+    loadContributions();
+    loadSymbolHashes();
+    _ipi.load(_msf, PdbTypeStream::IpiStreamIndex);
+    loadBuildInfos();
+    _names.load(_msf.stream(namedStreamIndex(QStringLiteral("/names"))));
+
+    return true;
+}
+
+void PdbFile::close()
+{
+    _lineTables.clear();
+    _buildInfos.clear();
+    _contributions.clear();
+    _sectionRvas.clear();
+    _symbolRecords.clear();
+    _publics.clear();
+    _globals.clear();
+    _names.clear();
+    _dbi.clear();
+    _ipi.clear();
+    _tpi.clear();
+    _namedStreams.clear();
+    _guid.clear();
+    _age = 0;
+    _msf.close();
+}
+
+CvSymbolIterator PdbFile::moduleSymbols(int module) const
+{
+    if (module < 0 || module >= _dbi.moduleCount())
+        return CvSymbolIterator();
+
+    const PdbModule& info = _dbi.module(module);
+    if (info.streamIndex == PdbDbiStream::NilStreamIndex)
+        return CvSymbolIterator();
+
+    return CvSymbolIterator(_msf.stream(info.streamIndex),
+                            CvSymbolIterator::ModuleSignatureSize, info.symbolBytes);
+}
+
+CvSymbolIterator PdbFile::globalSymbols() const
+{
+    return CvSymbolIterator(_symbolRecords, 0, quint32(_symbolRecords.size()));
+}
+
+QVector<quint32> PdbFile::moduleFiles(int module) const
+{
+    if (module < 0 || module >= _dbi.moduleCount())
+        return QVector<quint32>();
+
+    const PdbModule& info = _dbi.module(module);
+    if (info.streamIndex == PdbDbiStream::NilStreamIndex || info.c13Bytes == 0)
+        return QVector<quint32>();
+
+    quint32 begin = info.symbolBytes + info.c11Bytes;
+    return PdbLineTable::readFiles(_msf.stream(info.streamIndex), begin, begin + info.c13Bytes);
+}
+
+quint32 PdbFile::rva(quint16 segment, quint32 offset) const
+{
+    if (segment == 0 || segment > _sectionRvas.size())
+        return 0;
+
+    return _sectionRvas.at(segment - 1) + offset;
+}
+
+int PdbFile::findModule(quint32 rva) const
+{
+    int index = _contributions.find(rva);
+    return (index >= 0) ? int(_contributions.at(index).compiland) : -1;
+}
+
+bool PdbFile::findLine(quint32 rva, PdbLine* line) const
+{
+    QSharedPointer<const PdbLineTable> table = lineTable(findModule(rva));
+    return table && table->findLine(rva, line);
+}
+
+QSharedPointer<const PdbLineTable> PdbFile::lineTable(int module) const
+{
+    if (module < 0 || module >= _dbi.moduleCount())
+        return QSharedPointer<const PdbLineTable>();
+
+    if (QSharedPointer<const PdbLineTable>* cached = _lineTables.object(module))
+        return *cached;
+
+    const PdbModule& info = _dbi.module(module);
+    PdbLineTable* table = new PdbLineTable();
+
+    if (info.streamIndex != PdbDbiStream::NilStreamIndex && info.c13Bytes > 0)
+    {
+        quint32 begin = info.symbolBytes + info.c11Bytes;
+        table->load(_msf.stream(info.streamIndex), begin, begin + info.c13Bytes, _sectionRvas);
+    }
+
+    QSharedPointer<const PdbLineTable> result(table);
+    int cost = int(qMax<qint64>(1, table->memoryUsage() / 1024));
+    _lineTables.insert(module, new QSharedPointer<const PdbLineTable>(result), cost);
+    return result;
+}
+
+void PdbFile::setLineTableBudget(qint64 bytes)
+{
+    _lineTables.setMaxCost(int(qMin<qint64>(bytes / 1024, INT_MAX)));
+}
+
+QVector<CvSymbol> PdbFile::findChildren(enum SymTagEnum symtag, const QString& name,
+                                        quint32 compareFlags) const
+{
+    QVector<CvSymbol> result;
+    if (name.isEmpty())
+        return result;
+
+    QByteArray utf8 = name.toUtf8();
+    bool caseSensitive = (compareFlags & SearchCaseInsensitive) == 0;
+
+    if (symtag != SymTagPublicSymbol)
+        findInHash(_globals, symtag, utf8, caseSensitive, &result);
+
+    if (symtag == SymTagNull || symtag == SymTagPublicSymbol)
+        findInHash(_publics, symtag, utf8, caseSensitive, &result);
+
+    return result;
+}
+
+bool PdbFile::readSignature(const QString& fileName, QByteArray* guid, quint32* age)
+{
+    MsfFile msf;
+    if (!msf.open(fileName))
+        return false;
+
+    QByteArray info = msf.stream(InfoStreamIndex, 4 + 4 + 4 + 16);
+    const uchar* begin = reinterpret_cast<const uchar*>(info.constData());
+    CvReader reader(begin, begin + info.size());
+
+    reader.skip(4 + 4);
+    *age = reader.read32();
+    const uchar* data = reader.position();
+    reader.skip(16);
+    if (!reader.isValid())
+        return false;
+
+    *guid = QByteArray(reinterpret_cast<const char*>(data), 16);
+    return true;
+}
+
+bool PdbFile::loadInfoStream()
+{
+    QByteArray info = _msf.stream(InfoStreamIndex);
+    const uchar* begin = reinterpret_cast<const uchar*>(info.constData());
+    CvReader reader(begin, begin + info.size());
+
+    reader.skip(4 + 4);
+    _age = reader.read32();
+    const uchar* guid = reader.position();
+    reader.skip(16);
+    if (!reader.isValid())
+        return false;
+
+    _guid = QByteArray(reinterpret_cast<const char*>(guid), 16);
+
+    // Named stream map: string buffer followed by a serialized hash table
+    quint32 stringsSize = reader.read32();
+    const uchar* strings = reader.position();
+    reader.skip(int(stringsSize));
+
+    quint32 size = reader.read32();
+    quint32 capacity = reader.read32();
+    quint32 presentWords = reader.read32();
+    const uchar* present = reader.position();
+    reader.skip(int(presentWords * 4));
+    quint32 deletedWords = reader.read32();
+    reader.skip(int(deletedWords * 4));
+
+    if (!reader.isValid() || size > capacity)
+        return true;
+
+    for (quint32 i = 0; i < capacity && i < presentWords * 32; ++i)
+    {
+        quint32 word = qFromLittleEndian<quint32>(present + (i / 32) * 4);
+        if ((word & (1u << (i % 32))) == 0)
+            continue;
+
+        quint32 key = reader.read32();
+        quint32 value = reader.read32();
+        if (!reader.isValid() || key >= stringsSize)
+            break;
+
+        const char* name = reinterpret_cast<const char*>(strings) + key;
+        _namedStreams.insert(QString::fromUtf8(name, int(qstrnlen(name, stringsSize - key))), int(value));
+    }
+
+    return true;
+}
+
+bool PdbFile::loadSectionHeaders()
+{
+    QByteArray headers = _msf.stream(_dbi.debugStreamIndex(PdbDbiStream::DebugSectionHeaders));
+    int count = headers.size() / s_sectionHeaderSize;
+
+    _sectionRvas.resize(count);
+    for (int i = 0; i < count; ++i)
+    {
+        const char* header = headers.constData() + i * s_sectionHeaderSize;
+        _sectionRvas[i] = qFromLittleEndian<quint32>(header + s_sectionVirtualAddressOffset);
+    }
+
+    return (count > 0);
+}
+
+void PdbFile::loadContributions()
+{
+    QVector<PdbSectionContribution> contributions = _dbi.sectionContributions();
+
+    _contributions.reserve(contributions.size());
+    for (int i = 0; i < contributions.size(); ++i)
+    {
+        const PdbSectionContribution& contribution = contributions.at(i);
+        if (contribution.section == 0 || contribution.section > _sectionRvas.size())
+            continue;
+
+        _contributions.add(rva(contribution.section, contribution.offset), contribution.size,
+                           contribution.module, contribution.characteristics);
+    }
+
+    _contributions.build();
+}
+
+void PdbFile::loadBuildInfos()
+{
+    _buildInfos.resize(_dbi.moduleCount());
+
+    for (int i = 0; i < _dbi.moduleCount(); ++i)
+    {
+        const PdbModule& module = _dbi.module(i);
+        PdbBuildInfo& info = _buildInfos[i];
+        info.objectPath = _dbi.moduleName(i);
+
+        if (module.streamIndex == PdbDbiStream::NilStreamIndex)
+            continue;
+
+        // The first block is tried alone, the whole stream only when it holds no build record
+        quint32 prefix = qMin(module.symbolBytes, _msf.blockSize());
+        if (!readBuildInfo(_msf.stream(module.streamIndex, prefix), prefix, &info) &&
+            prefix < module.symbolBytes)
+        {
+            readBuildInfo(_msf.stream(module.streamIndex), module.symbolBytes, &info);
+        }
+    }
+}
+
+bool PdbFile::readBuildInfo(const QByteArray& stream, quint32 end, PdbBuildInfo* info) const
+{
+    CvSymbolIterator symbols(stream, CvSymbolIterator::ModuleSignatureSize, end);
+    CvSymbol symbol;
+
+    while (symbols.next(&symbol))
+    {
+        CvReader reader(symbol.data, symbol.end());
+
+        switch (symbol.kind)
+        {
+        case S_OBJNAME:
+        {
+            reader.skip(4);
+            QString path = reader.readString();
+            if (!path.isEmpty())
+                info->objectPath = path;
+            break;
+        }
+        case S_BUILDINFO:
+        {
+            PdbTypeRecord record = _ipi.record(reader.read32());
+            if (!record.isValid() || record.kind != LF_BUILDINFO)
+                break;
+
+            CvReader arguments(record.data, record.end());
+            quint16 count = arguments.read16();
+            QString* fields[] = { &info->currentDirectory, &info->compiler, &info->sourceFile,
+                                  nullptr, &info->commandLine };
+
+            for (int i = 0; i < count && i < 5 && arguments.remaining() >= 4; ++i)
+            {
+                quint32 id = arguments.read32();
+                if (fields[i])
+                    *fields[i] = _ipi.stringId(id);
+            }
+            return true;
+        }
+        case S_ENVBLOCK:
+        {
+            // Older compilers write key/value string pairs instead of LF_BUILDINFO
+            reader.skip(1);
+            while (!reader.atEnd())
+            {
+                QString key = reader.readString();
+                if (key.isEmpty())
+                    break;
+
+                QString value = reader.readString();
+                if (key == QLatin1String("cwd") && info->currentDirectory.isEmpty())
+                    info->currentDirectory = value;
+                else if (key == QLatin1String("exe") && info->compiler.isEmpty())
+                    info->compiler = value;
+                else if (key == QLatin1String("src") && info->sourceFile.isEmpty())
+                    info->sourceFile = value;
+                else if (key == QLatin1String("cmd") && info->commandLine.isEmpty())
+                    info->commandLine = value;
+            }
+            return true;
+        }
+        default:
+            // Namespaces and often whole procedures come before S_BUILDINFO, scopes are stepped over
+            if (CvSymbolIterator::opensScope(symbol.kind) && !symbols.skipScope(symbol))
+                return false;
+            break;
+        }
+    }
+
+    return false;
+}
+
+bool PdbFile::loadSymbolHashes()
+{
+    _symbolRecords = _msf.stream(_dbi.symbolRecordsStreamIndex());
+    if (_symbolRecords.isEmpty())
+        return false;
+
+    QByteArray globals = _msf.stream(_dbi.globalsStreamIndex());
+    bool loaded = _globals.load(globals, 0, globals.size());
+
+    QByteArray publics = _msf.stream(_dbi.publicsStreamIndex());
+    if (publics.size() >= PdbSymbolHash::PublicsHeaderSize)
+    {
+        int hashSize = int(qFromLittleEndian<quint32>(publics.constData()));
+        loaded &= _publics.load(publics, PdbSymbolHash::PublicsHeaderSize, hashSize);
+    }
+
+    return loaded;
+}
+
+void PdbFile::findInHash(const PdbSymbolHash& hash, enum SymTagEnum symtag, const QByteArray& name,
+                         bool caseSensitive, QVector<CvSymbol>* result) const
+{
+    if (!hash.isLoaded())
+        return;
+
+    quint32 bucket = PdbSymbolHash::bucketOf(name.constData(), name.size());
+    for (int i = hash.bucketBegin(bucket); i < hash.bucketEnd(bucket); ++i)
+    {
+        CvSymbol symbol = symbolRecord(hash.recordOffset(i));
+        if (!symbol.data || !matchesTag(symbol, symtag))
+            continue;
+
+        int size = 0;
+        const char* symbolName = CvSymbolIterator::readName(symbol, &size);
+        if (!symbolName || size != name.size())
+            continue;
+
+        bool equal = caseSensitive ? (memcmp(symbolName, name.constData(), size) == 0)
+                                   : (qstrnicmp(symbolName, name.constData(), uint(size)) == 0);
+        if (equal)
+            result->append(symbol);
+    }
+}
+
+bool PdbFile::matchesTag(const CvSymbol& symbol, enum SymTagEnum symtag) const
+{
+    switch (symtag)
+    {
+    case SymTagNull:
+        return true;
+    case SymTagPublicSymbol:
+        return (symbol.kind == S_PUB32);
+    case SymTagFunction:
+        return (symbol.kind == S_PROCREF || symbol.kind == S_LPROCREF);
+    case SymTagData:
+        return (symbol.kind == S_GDATA32 || symbol.kind == S_LDATA32 ||
+                symbol.kind == S_CONSTANT || symbol.kind == S_DATAREF);
+    case SymTagTypedef:
+    case SymTagUDT:
+    case SymTagEnum:
+    {
+        if (symbol.kind != S_UDT)
+            return false;
+
+        // S_UDT names typedefs, classes and enums alike, the referenced type tells them apart
+        quint16 kind = _tpi.record(qFromLittleEndian<quint32>(symbol.data)).kind;
+        if (symtag == SymTagEnum)
+            return (kind == LF_ENUM);
+        if (symtag == SymTagUDT)
+            return (kind == LF_CLASS || kind == LF_STRUCTURE || kind == LF_UNION || kind == LF_INTERFACE);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+CvSymbol PdbFile::symbolRecord(quint32 offset) const
+{
+    CvSymbol symbol = { 0, 0, 0, nullptr };
+    CvSymbolIterator iterator(_symbolRecords, offset, quint32(_symbolRecords.size()));
+    if (!iterator.next(&symbol))
+        symbol.data = nullptr;
+
+    return symbol;
+}
@@ -0,0 +1,171 @@
+#ifndef PDBFILE_H
+#define PDBFILE_H
+
+
+#include "contributionindex.h"
+#include "cvsymbols.h"
+#include "msf.h"
+#include "pdbgsi.h"
+#include "pdblines.h"
+#include "pdbnames.h"
+#include "pdbdbi.h"
+#include "pdbtpi.h"
+
+#include <QCache>
+#include <QSharedPointer>
+
+#include <cvconst.h>
+
+
+struct PdbBuildInfo
+{
+    QString objectPath;
+    QString currentDirectory;
+    QString compiler;
+    QString sourceFile;
+    QString commandLine;
+};
+
+
+class PdbFile
+{
+public:
+    // Same values as DIA's NameSearchOptions so compare flags can be passed through
+    enum NameSearchFlags
+    {
+        SearchCaseSensitive     = 0x1,
+        SearchCaseInsensitive   = 0x2
+    };
+
+    enum
+    {
+        InfoStreamIndex = 1,
+        DefaultLineTableBudget = 256 * 1024 * 1024
+    };
+
+public:
+    PdbFile();
+
+    bool open(const QString& fileName);
+    void close();
+    bool isOpen() const;
+
+    // Reads only the GUID and age of the info stream, to match a PDB to an image without loading it
+    static bool readSignature(const QString& fileName, QByteArray* guid, quint32* age);
+
+    const MsfFile& msf() const;
+    quint32 age() const;
+    QByteArray guid() const;
+    int namedStreamIndex(const QString& name) const;
+
+    const PdbTypeStream& types() const;
+    const PdbTypeStream& ids() const;
+    const PdbDbiStream& dbi() const;
+    const PdbStringTable& strings() const;
+
+    CvSymbolIterator moduleSymbols(int module) const;
+    CvSymbolIterator globalSymbols() const;
+    QVector<quint32> moduleFiles(int module) const;
+    PdbBuildInfo buildInfo(int module) const;
+
+    quint32 rva(quint16 segment, quint32 offset) const;
+
+    const ContributionIndex& contributions() const;
+    int findModule(quint32 rva) const;
+    bool findLine(quint32 rva, PdbLine* line) const;
+
+    QSharedPointer<const PdbLineTable> lineTable(int module) const;
+    void setLineTableBudget(qint64 bytes);
+
+    QVector<CvSymbol> findChildren(enum SymTagEnum symtag, const QString& name,
+                                   quint32 compareFlags = SearchCaseSensitive) const;
+
+private:
+    bool loadInfoStream();
+    bool loadSectionHeaders();
+    void loadContributions();
+    void loadBuildInfos();
+    bool readBuildInfo(const QByteArray& stream, quint32 end, PdbBuildInfo* info) const;
+    bool loadSymbolHashes();
+    void findInHash(const PdbSymbolHash& hash, enum SymTagEnum symtag, const QByteArray& name,
+                    bool caseSensitive, QVector<CvSymbol>* result) const;
+    bool matchesTag(const CvSymbol& symbol, enum SymTagEnum symtag) const;
+    CvSymbol symbolRecord(quint32 offset) const;
+
+private:
+    MsfFile _msf;
+    quint32 _age;
+    QByteArray _guid;
+    QHash<QString, int> _namedStreams;
+    PdbTypeStream _tpi;
+    PdbTypeStream _ipi;
+    PdbDbiStream _dbi;
+    PdbStringTable _names;
+    PdbSymbolHash _globals;
+    PdbSymbolHash _publics;
+    QByteArray _symbolRecords;
+    QVector<quint32> _sectionRvas;
+    ContributionIndex _contributions;
+    QVector<PdbBuildInfo> _buildInfos;
+    // Line tables are rebuilt on demand, the cache cost is counted in KiB
+    mutable QCache<int, QSharedPointer<const PdbLineTable>> _lineTables;
+};
+
+
+inline bool PdbFile::isOpen() const
+{
+    return _msf.isOpen();
+}
+
+inline const MsfFile& PdbFile::msf() const
+{
+    return _msf;
+}
+
+inline quint32 PdbFile::age() const
+{
+    return _age;
+}
+
+inline QByteArray PdbFile::guid() const
+{
+    return _guid;
+}
+
+inline int PdbFile::namedStreamIndex(const QString& name) const
+{
+    return _namedStreams.value(name, -1);
+}
+
+inline const ContributionIndex& PdbFile::contributions() const
+{
+    return _contributions;
+}
+
+inline const PdbTypeStream& PdbFile::types() const
+{
+    return _tpi;
+}
+
+inline const PdbTypeStream& PdbFile::ids() const
+{
+    return _ipi;
+}
+
+inline PdbBuildInfo PdbFile::buildInfo(int module) const
+{
+    return _buildInfos.value(module);
+}
+
+inline const PdbDbiStream& PdbFile::dbi() const
+{
+    return _dbi;
+}
+
+inline const PdbStringTable& PdbFile::strings() const
+{
+    return _names;
+}
+
+
+#endif // PDBFILE_H
@@ -0,0 +1,113 @@
+#include "pdbgsi.h"
+
+#include "codeview.h"
+
+
+static const quint32 s_gsiSignature = 0xFFFFFFFF;
+static const quint32 s_gsiVersion70 = 0xEFFE0000 + 19990810;
+static const int s_gsiHeaderSize = 16;
+static const int s_hashRecordSize = 8;
+// Bucket offsets are stored as offsets into the in-memory 12-byte records
+static const int s_hashRecordMemorySize = 12;
+static const int s_bitmapWords = (PdbSymbolHash::BucketCount + 1 + 31) / 32;
+
+PdbSymbolHash::PdbSymbolHash()
+{
+}
+
+bool PdbSymbolHash::load(const QByteArray& stream, int offset, int size)
+{
+    clear();
+
+    if (offset < 0 || size < s_gsiHeaderSize || offset + size > stream.size())
+        return false;
+
+    const uchar* data = reinterpret_cast<const uchar*>(stream.constData()) + offset;
+    CvReader reader(data, data + size);
+
+    quint32 signature = reader.read32();
+    quint32 version = reader.read32();
+    quint32 recordsSize = reader.read32();
+    quint32 bucketsSize = reader.read32();
+
+    if (signature != s_gsiSignature || version != s_gsiVersion70 ||
+        quint64(recordsSize) + bucketsSize > quint64(reader.remaining()) ||
+        bucketsSize < quint32(s_bitmapWords * 4))
+    {
+        return false;
+    }
+
+    int recordCount = int(recordsSize / s_hashRecordSize);
+    _records.resize(recordCount);
+    for (int i = 0; i < recordCount; ++i)
+    {
+        // Offsets are stored biased by one so that zero can mean "deleted"
+        _records[i] = reader.read32() - 1;
+        reader.skip(4);
+    }
+
+    const uchar* bitmap = reader.position();
+    reader.skip(s_bitmapWords * 4);
+
+    _buckets.fill(recordCount, BucketCount + 1);
+
+    for (int i = 0; i < BucketCount; ++i)
+    {
+        quint32 word = qFromLittleEndian<quint32>(bitmap + (i / 32) * 4);
+        if (word & (1u << (i % 32)))
+        {
+            int start = int(reader.read32() / s_hashRecordMemorySize);
+            if (!reader.isValid() || start > recordCount)
+            {
+                clear();
+                return false;
+            }
+            _buckets[i] = start;
+        }
+        else
+        {
+            _buckets[i] = -1;
+        }
+    }
+
+    // Empty buckets take the start of the next non-empty bucket so every range is [begin, end)
+    for (int i = BucketCount - 1; i >= 0; --i)
+    {
+        if (_buckets.at(i) < 0)
+            _buckets[i] = _buckets.at(i + 1);
+    }
+
+    return true;
+}
+
+void PdbSymbolHash::clear()
+{
+    _records.clear();
+    _buckets.clear();
+}
+
+quint32 PdbSymbolHash::hashName(const char* name, int size)
+{
+    const uchar* data = reinterpret_cast<const uchar*>(name);
+    quint32 result = 0;
+
+    int longs = size / 4;
+    for (int i = 0; i < longs; ++i)
+        result ^= qFromLittleEndian<quint32>(data + i * 4);
+
+    data += longs * 4;
+    int remainder = size % 4;
+    if (remainder >= 2)
+    {
+        result ^= qFromLittleEndian<quint16>(data);
+        data += 2;
+        remainder -= 2;
+    }
+    if (remainder == 1)
+        result ^= *data;
+
+    // Folding in the ASCII case bit makes the hash case-insensitive
+    result |= 0x20202020;
+    result ^= (result >> 11);
+    return result ^ (result >> 16);
+}
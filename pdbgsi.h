@@ -0,0 +1,72 @@
+#ifndef PDBGSI_H
+#define PDBGSI_H
+
+
+#include <QByteArray>
+#include <QVector>
+
+
+// Name hash table shared by the global (GSI) and public (PSI) symbol streams
+class PdbSymbolHash
+{
+public:
+    enum
+    {
+        BucketCount = 4096,
+        PublicsHeaderSize = 28
+    };
+
+public:
+    PdbSymbolHash();
+
+    bool load(const QByteArray& stream, int offset, int size);
+    void clear();
+    bool isLoaded() const;
+
+    int recordCount() const;
+    quint32 recordOffset(int index) const;
+
+    int bucketBegin(quint32 bucket) const;
+    int bucketEnd(quint32 bucket) const;
+
+    static quint32 hashName(const char* name, int size);
+    static quint32 bucketOf(const char* name, int size);
+
+private:
+    QVector<quint32> _records;
+    QVector<int> _buckets;
+};
+
+
+inline bool PdbSymbolHash::isLoaded() const
+{
+    return !_buckets.isEmpty();
+}
+
+inline int PdbSymbolHash::recordCount() const
+{
+    return _records.size();
+}
+
+inline quint32 PdbSymbolHash::recordOffset(int index) const
+{
+    return _records.at(index);
+}
+
+inline int PdbSymbolHash::bucketBegin(quint32 bucket) const
+{
+    return _buckets.at(int(bucket));
+}
+
+inline int PdbSymbolHash::bucketEnd(quint32 bucket) const
+{
+    return _buckets.at(int(bucket) + 1);
+}
+
+inline quint32 PdbSymbolHash::bucketOf(const char* name, int size)
+{
+    return hashName(name, size) % BucketCount;
+}
+
+
+#endif // PDBGSI_H
@@ -0,0 +1,376 @@
+#include "pdblines.h"
+
+#include "codeview.h"
+
+#include <QHash>
+#include <QPair>
+
+#include <algorithm>
+
+
+static const quint32 s_debugSubsectionIgnore = 0x80000000;
+static const quint32 s_debugSubsectionLines = 0xF2;
+static const quint32 s_debugSubsectionFileChecksums = 0xF4;
+static const quint16 s_linesHaveColumns = 0x0001;
+static const quint32 s_hiddenLine = 0xFEEFEE;
+static const quint32 s_hiddenLineAlternative = 0xF00F00;
+
+static inline void writeVarint(QByteArray* output, quint64 value)
+{
+    while (value >= 0x80)
+    {
+        output->append(char(value | 0x80));
+        value >>= 7;
+    }
+    output->append(char(value));
+}
+
+static inline quint64 readVarint(const uchar** data)
+{
+    quint64 result = 0;
+    int shift = 0;
+    const uchar* current = *data;
+
+    while (*current & 0x80)
+    {
+        result |= quint64(*current++ & 0x7F) << shift;
+        shift += 7;
+    }
+    result |= quint64(*current++) << shift;
+
+    *data = current;
+    return result;
+}
+
+// Maps each FILECHKSMS entry offset to the /names offset of its file
+static void readChecksums(const uchar* subsection, quint32 size, QVector<QPair<quint32, quint32>>* checksums)
+{
+    CvReader files(subsection, subsection + size);
+    while (files.remaining() >= 6)
+    {
+        quint32 checksumOffset = quint32(files.position() - subsection);
+        quint32 nameOffset = files.read32();
+        quint8 checksumSize = files.read8();
+        files.skip(1 + checksumSize);
+        files.skip((4 - ((files.position() - subsection) & 3)) & 3);
+        checksums->append(qMakePair(checksumOffset, nameOffset));
+    }
+}
+
+PdbLineTable::PdbLineTable()
+    : _count(0)
+{
+}
+
+bool PdbLineTable::load(const QByteArray& stream, quint32 begin, quint32 end,
+                        const QVector<quint32>& sectionRvas)
+{
+    clear();
+
+    if (begin > end || end > quint32(stream.size()))
+        return false;
+
+    const uchar* data = reinterpret_cast<const uchar*>(stream.constData());
+
+    QVector<Entry> entries;
+    if (!readLines(data + begin, data + end, sectionRvas, &entries))
+        return false;
+
+    // Ties put the end-of-contribution markers first so a real line starting there wins
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& left, const Entry& right)
+    {
+        if (left.rva != right.rva)
+            return left.rva < right.rva;
+        return (left.line == 0 && right.line != 0);
+    });
+
+    encode(entries);
+    return true;
+}
+
+void PdbLineTable::clear()
+{
+    _deltas.clear();
+    _checkpoints.clear();
+    _files.clear();
+    _count = 0;
+    _locations.clear();
+}
+
+bool PdbLineTable::findLine(quint32 rva, PdbLine* line) const
+{
+    auto checkpoint = std::upper_bound(_checkpoints.constBegin(), _checkpoints.constEnd(), rva,
+                                       [](quint32 value, const Checkpoint& point)
+                                       { return value < point.rva; });
+    if (checkpoint == _checkpoints.constBegin())
+        return false;
+
+    --checkpoint;
+    int index = int(checkpoint - _checkpoints.constBegin());
+
+    Entry current = { checkpoint->rva, checkpoint->line, checkpoint->file };
+    Entry next = current;
+    bool hasNext = false;
+
+    const uchar* data = reinterpret_cast<const uchar*>(_deltas.constData()) + checkpoint->offset;
+    int remaining = qMin(int(CheckpointInterval), _count - index * CheckpointInterval) - 1;
+
+    while (remaining-- > 0)
+    {
+        decodeNext(&data, &next);
+        if (next.rva > rva)
+        {
+            hasNext = true;
+            break;
+        }
+        current = next;
+    }
+
+    if (!hasNext && index + 1 < _checkpoints.size())
+    {
+        next.rva = _checkpoints.at(index + 1).rva;
+        hasNext = true;
+    }
+
+    // Line zero marks the gap after a contribution
+    if (!hasNext || current.line == 0)
+        return false;
+
+    line->rva = current.rva;
+    line->length = next.rva - current.rva;
+    line->fileId = _files.at(int(current.file));
+    line->line = current.line;
+    return true;
+}
+
+QVector<quint32> PdbLineTable::findAddresses(quint32 fileId, quint32 line) const
+{
+    QVector<quint32> result;
+
+    int file = _files.indexOf(fileId);
+    if (line == 0 || file < 0)
+        return result;
+
+    if (_locations.isEmpty())
+        buildLocations();
+
+    Location key = { quint32(file), line, 0 };
+    auto it = std::lower_bound(_locations.constBegin(), _locations.constEnd(), key);
+    for (; it != _locations.constEnd() && it->file == key.file && it->line == line; ++it)
+        result.append(it->rva);
+
+    return result;
+}
+
+qint64 PdbLineTable::memoryUsage() const
+{
+    return sizeof(PdbLineTable) + _deltas.capacity() +
+           qint64(_checkpoints.capacity()) * sizeof(Checkpoint) +
+           qint64(_files.capacity()) * sizeof(quint32);
+}
+
+QVector<quint32> PdbLineTable::readFiles(const QByteArray& stream, quint32 begin, quint32 end)
+{
+    QVector<quint32> result;
+
+    if (begin > end || end > quint32(stream.size()))
+        return result;
+
+    const uchar* data = reinterpret_cast<const uchar*>(stream.constData());
+    CvReader reader(data + begin, data + end);
+
+    while (reader.remaining() >= 8)
+    {
+        quint32 kind = reader.read32() & ~s_debugSubsectionIgnore;
+        quint32 size = reader.read32();
+
+        if (size > quint32(reader.remaining()))
+            break;
+
+        if (kind == s_debugSubsectionFileChecksums)
+        {
+            QVector<QPair<quint32, quint32>> files;
+            readChecksums(reader.position(), size, &files);
+            for (int i = 0; i < files.size(); ++i)
+                result.append(files.at(i).second);
+        }
+
+        reader.skip(qMin(int((size + 3) & ~3u), reader.remaining()));
+    }
+
+    return result;
+}
+
+bool PdbLineTable::readLines(const uchar* data, const uchar* end, const QVector<quint32>& sectionRvas,
+                             QVector<Entry>* entries) const
+{
+    QHash<quint32, quint32> checksums;
+    QVector<QPair<const uchar*, const uchar*>> lines;
+
+    CvReader reader(data, end);
+    while (reader.remaining() >= 8)
+    {
+        quint32 kind = reader.read32() & ~s_debugSubsectionIgnore;
+        quint32 size = reader.read32();
+        const uchar* subsection = reader.position();
+
+        if (size > quint32(reader.remaining()))
+            return false;
+
+        if (kind == s_debugSubsectionLines)
+        {
+            lines.append(qMakePair(subsection, subsection + size));
+        }
+        else if (kind == s_debugSubsectionFileChecksums)
+        {
+            QVector<QPair<quint32, quint32>> files;
+            readChecksums(subsection, size, &files);
+            for (int i = 0; i < files.size(); ++i)
+                checksums.insert(files.at(i).first, files.at(i).second);
+        }
+
+        reader.skip(qMin(int((size + 3) & ~3u), reader.remaining()));
+    }
+
+    for (int i = 0; i < lines.size(); ++i)
+    {
+        CvReader contribution(lines.at(i).first, lines.at(i).second);
+        quint32 offset = contribution.read32();
+        quint16 segment = contribution.read16();
+        quint16 flags = contribution.read16();
+        quint32 codeSize = contribution.read32();
+
+        if (!contribution.isValid() || segment == 0 || segment > sectionRvas.size())
+            continue;
+
+        quint32 base = sectionRvas.at(segment - 1) + offset;
+        int entrySize = (flags & s_linesHaveColumns) ? 12 : 8;
+
+        while (contribution.remaining() >= 12)
+        {
+            quint32 checksumOffset = contribution.read32();
+            quint32 count = contribution.read32();
+            quint32 blockSize = contribution.read32();
+
+            if (blockSize < 12 || blockSize - 12 > quint32(contribution.remaining()) ||
+                quint64(count) * entrySize > blockSize - 12)
+            {
+                break;
+            }
+
+            quint32 fileId = checksums.value(checksumOffset);
+            CvReader block(contribution.position(), contribution.position() + count * 8);
+            for (quint32 j = 0; j < count; ++j)
+            {
+                Entry entry;
+                entry.rva = base + block.read32();
+                entry.line = block.read32() & 0xFFFFFF;
+                entry.file = fileId;
+
+                if (entry.line == s_hiddenLine || entry.line == s_hiddenLineAlternative)
+                    entry.line = 0;
+
+                entries->append(entry);
+            }
+
+            contribution.skip(int(blockSize - 12));
+        }
+
+        Entry marker = { base + codeSize, 0, 0 };
+        entries->append(marker);
+    }
+
+    return reader.isValid();
+}
+
+void PdbLineTable::encode(const QVector<Entry>& entries)
+{
+    QHash<quint32, quint32> fileIndices;
+
+    _count = entries.size();
+    _checkpoints.reserve((_count + CheckpointInterval - 1) / CheckpointInterval);
+    _deltas.reserve(_count * 3);
+
+    Entry previous = { 0, 0, 0 };
+    for (int i = 0; i < _count; ++i)
+    {
+        Entry entry = entries.at(i);
+
+        // Markers carry no file, keep the previous one so they cost a single byte pair
+        if (entry.line == 0)
+        {
+            entry.file = previous.file;
+        }
+        else
+        {
+            auto it = fileIndices.constFind(entry.file);
+            if (it == fileIndices.constEnd())
+            {
+                it = fileIndices.insert(entry.file, quint32(_files.size()));
+                _files.append(entry.file);
+            }
+            entry.file = it.value();
+        }
+
+        if (i % CheckpointInterval == 0)
+        {
+            Checkpoint checkpoint = { entry.rva, entry.line, entry.file, quint32(_deltas.size()) };
+            _checkpoints.append(checkpoint);
+        }
+        else
+        {
+            bool fileChanged = (entry.file != previous.file);
+            qint64 lineDelta = qint64(entry.line) - qint64(previous.line);
+
+            writeVarint(&_deltas, (quint64(entry.rva - previous.rva) << 1) | (fileChanged ? 1 : 0));
+            writeVarint(&_deltas, quint64((lineDelta << 1) ^ (lineDelta >> 63)));
+            if (fileChanged)
+                writeVarint(&_deltas, entry.file);
+        }
+
+        previous = entry;
+    }
+
+    _deltas.squeeze();
+    _checkpoints.squeeze();
+    _files.squeeze();
+}
+
+void PdbLineTable::decodeNext(const uchar** data, Entry* entry) const
+{
+    quint64 address = readVarint(data);
+    quint64 line = readVarint(data);
+
+    entry->rva += quint32(address >> 1);
+    entry->line = quint32(qint64(entry->line) + qint64((line >> 1) ^ (~(line & 1) + 1)));
+    if (address & 1)
+        entry->file = quint32(readVarint(data));
+}
+
+void PdbLineTable::buildLocations() const
+{
+    _locations.reserve(_count);
+
+    for (int index = 0; index < _checkpoints.size(); ++index)
+    {
+        const Checkpoint& checkpoint = _checkpoints.at(index);
+        Entry entry = { checkpoint.rva, checkpoint.line, checkpoint.file };
+
+        const uchar* data = reinterpret_cast<const uchar*>(_deltas.constData()) + checkpoint.offset;
+        int remaining = qMin(int(CheckpointInterval), _count - index * CheckpointInterval);
+
+        while (remaining-- > 0)
+        {
+            if (entry.line != 0)
+            {
+                Location location = { entry.file, entry.line, entry.rva };
+                _locations.append(location);
+            }
+            if (remaining > 0)
+                decodeNext(&data, &entry);
+        }
+    }
+
+    std::sort(_locations.begin(), _locations.end());
+    _locations.squeeze();
+}
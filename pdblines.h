@@ -0,0 +1,110 @@
+#ifndef PDBLINES_H
+#define PDBLINES_H
+
+
+#include <QByteArray>
+#include <QVector>
+
+
+struct PdbLine
+{
+    quint32 rva;
+    quint32 length;
+    quint32 fileId;
+    quint32 line;
+};
+
+
+// Address-ordered line table of one module, stored as delta-encoded runs
+// with a checkpoint every CheckpointInterval entries for binary search
+class PdbLineTable
+{
+public:
+    enum { CheckpointInterval = 64 };
+
+public:
+    PdbLineTable();
+
+    bool load(const QByteArray& stream, quint32 begin, quint32 end,
+              const QVector<quint32>& sectionRvas);
+    void clear();
+    bool isEmpty() const;
+
+    int lineCount() const;
+    const QVector<quint32>& files() const;
+
+    bool findLine(quint32 rva, PdbLine* line) const;
+    QVector<quint32> findAddresses(quint32 fileId, quint32 line) const;
+
+    // Size of the forward table, the lazily built reverse map is not counted
+    qint64 memoryUsage() const;
+
+    static QVector<quint32> readFiles(const QByteArray& stream, quint32 begin, quint32 end);
+
+private:
+    struct Entry
+    {
+        quint32 rva;
+        quint32 line;
+        quint32 file;
+    };
+
+    struct Checkpoint
+    {
+        quint32 rva;
+        quint32 line;
+        quint32 file;
+        quint32 offset;
+    };
+
+    struct Location
+    {
+        quint32 file;
+        quint32 line;
+        quint32 rva;
+
+        bool operator<(const Location& other) const;
+    };
+
+    bool readLines(const uchar* data, const uchar* end, const QVector<quint32>& sectionRvas,
+                   QVector<Entry>* entries) const;
+    void encode(const QVector<Entry>& entries);
+    void decodeNext(const uchar** data, Entry* entry) const;
+    void buildLocations() const;
+
+private:
+    QByteArray _deltas;
+    QVector<Checkpoint> _checkpoints;
+    QVector<quint32> _files;
+    int _count;
+    // Reverse map, decoded on the first findAddresses()
+    mutable QVector<Location> _locations;
+};
+
+
+inline bool PdbLineTable::isEmpty() const
+{
+    return (_count == 0);
+}
+
+inline int PdbLineTable::lineCount() const
+{
+    return _count;
+}
+
+inline const QVector<quint32>& PdbLineTable::files() const
+{
+    return _files;
+}
+
+inline bool PdbLineTable::Location::operator<(const Location& other) const
+{
+    if (file != other.file)
+        return file < other.file;
+    if (line != other.line)
+        return line < other.line;
+    return rva < other.rva;
+}
+
+
+#endif // PDBLINES_H
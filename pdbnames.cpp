@@ -0,0 +1,133 @@
+#include "pdbnames.h"
+
+#include "codeview.h"
+#include "pdbgsi.h"
+
+#include <cstring>
+
+
+static const quint32 s_namesSignature = 0xEFFEEFFE;
+static const quint32 s_namesHashVersion1 = 1;
+
+PdbStringTable::PdbStringTable()
+    : _stringsOffset(0)
+    , _stringsSize(0)
+    , _hashVersion(0)
+    , _count(0)
+{
+}
+
+bool PdbStringTable::load(const QByteArray& stream)
+{
+    clear();
+
+    const uchar* begin = reinterpret_cast<const uchar*>(stream.constData());
+    CvReader reader(begin, begin + stream.size());
+
+    quint32 signature = reader.read32();
+    quint32 hashVersion = reader.read32();
+    quint32 stringsSize = reader.read32();
+
+    if (!reader.isValid() || signature != s_namesSignature || stringsSize > quint32(reader.remaining()))
+        return false;
+
+    int stringsOffset = int(reader.position() - begin);
+    reader.skip(int(stringsSize));
+
+    quint32 bucketCount = reader.read32();
+    if (!reader.isValid() || quint64(bucketCount) * 4 > quint64(reader.remaining()))
+        return false;
+
+    _buckets.resize(int(bucketCount));
+    for (quint32 i = 0; i < bucketCount; ++i)
+        _buckets[i] = reader.read32();
+
+    int count = int(reader.read32());
+    if (!reader.isValid())
+    {
+        clear();
+        return false;
+    }
+
+    _data = stream;
+    _stringsOffset = stringsOffset;
+    _stringsSize = int(stringsSize);
+    _hashVersion = hashVersion;
+    _count = count;
+    return true;
+}
+
+void PdbStringTable::clear()
+{
+    _data.clear();
+    _stringsOffset = 0;
+    _stringsSize = 0;
+    _hashVersion = 0;
+    _buckets.clear();
+    _count = 0;
+    _strings.clear();
+}
+
+const char* PdbStringTable::data(quint32 id, int* size) const
+{
+    if (!contains(id))
+        return nullptr;
+
+    const char* string = _data.constData() + _stringsOffset + id;
+    if (size)
+        *size = int(qstrnlen(string, uint(_stringsSize) - id));
+
+    return string;
+}
+
+QString PdbStringTable::string(quint32 id) const
+{
+    // Decoded strings are kept so every user of an ID shares one QString
+    auto it = _strings.constFind(id);
+    if (it != _strings.constEnd())
+        return it.value();
+
+    int size = 0;
+    const char* string = data(id, &size);
+    if (!string)
+        return QString();
+
+    return _strings.insert(id, QString::fromUtf8(string, size)).value();
+}
+
+quint32 PdbStringTable::find(const QByteArray& name) const
+{
+    if (_buckets.isEmpty())
+        return InvalidId;
+
+    int size = 0;
+    if (_hashVersion == s_namesHashVersion1)
+    {
+        quint32 count = quint32(_buckets.size());
+        quint32 start = PdbSymbolHash::hashName(name.constData(), name.size()) % count;
+
+        for (quint32 i = 0; i < count; ++i)
+        {
+            quint32 id = _buckets.at(int((start + i) % count));
+            if (id == 0)
+                return InvalidId;
+
+            const char* string = data(id, &size);
+            if (string && size == name.size() && memcmp(string, name.constData(), size) == 0)
+                return id;
+        }
+
+        return InvalidId;
+    }
+
+    // Other hash versions are rare, probe every bucket instead of guessing the hash
+    for (int i = 0; i < _buckets.size(); ++i)
+    {
+        quint32 id = _buckets.at(i);
+        const char* string = id ? data(id, &size) : nullptr;
+        if (string && size == name.size() && memcmp(string, name.constData(), size) == 0)
+            return id;
+    }
+
+    return InvalidId;
+}
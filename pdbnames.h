@@ -0,0 +1,65 @@
+#ifndef PDBNAMES_H
+#define PDBNAMES_H
+
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+
+// The /names stream, string IDs are byte offsets into its buffer and stay
+// stable for the lifetime of the PDB
+class PdbStringTable
+{
+public:
+    enum { InvalidId = 0xFFFFFFFF };
+
+public:
+    PdbStringTable();
+
+    bool load(const QByteArray& stream);
+    void clear();
+    bool isLoaded() const;
+
+    int count() const;
+    bool contains(quint32 id) const;
+
+    const char* data(quint32 id, int* size = nullptr) const;
+    QString string(quint32 id) const;
+    quint32 find(const QByteArray& name) const;
+    quint32 find(const QString& name) const;
+
+private:
+    QByteArray _data;
+    int _stringsOffset;
+    int _stringsSize;
+    quint32 _hashVersion;
+    QVector<quint32> _buckets;
+    int _count;
+    mutable QHash<quint32, QString> _strings;
+};
+
+
+inline bool PdbStringTable::isLoaded() const
+{
+    return !_data.isEmpty();
+}
+
+inline int PdbStringTable::count() const
+{
+    return _count;
+}
+
+inline bool PdbStringTable::contains(quint32 id) const
+{
+    return (id < quint32(_stringsSize));
+}
+
+inline quint32 PdbStringTable::find(const QString& name) const
+{
+    return find(name.toUtf8());
+}
+
+
+#endif // PDBNAMES_H
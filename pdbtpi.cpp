@@ -0,0 +1,527 @@
+#include "pdbtpi.h"
+
+#include "codeview.h"
+#include "msf.h"
+
+#include <algorithm>
+
+
+static const quint32 s_tpiVersion80 = 20040203;
+static const quint32 s_tpiHeaderSize = 56;
+static const int s_maxTypeDepth = 32;
+
+PdbTypeStream::PdbTypeStream()
+    : _headerSize(0)
+    , _begin(0)
+    , _end(0)
+{
+}
+
+bool PdbTypeStream::load(const MsfFile& msf, int streamIndex)
+{
+    clear();
+
+    QByteArray data = msf.stream(streamIndex);
+    if (quint32(data.size()) < s_tpiHeaderSize)
+        return false;
+
+    const uchar* header = reinterpret_cast<const uchar*>(data.constData());
+    CvReader reader(header, header + s_tpiHeaderSize);
+
+    quint32 version = reader.read32();
+    quint32 headerSize = reader.read32();
+    quint32 begin = reader.read32();
+    quint32 end = reader.read32();
+    quint32 recordBytes = reader.read32();
+    quint16 hashStream = reader.read16();
+    reader.skip(2 + 4 + 4 + 4 + 4);
+    qint32 indexOffsetsOffset = qint32(reader.read32());
+    quint32 indexOffsetsLength = reader.read32();
+
+    if (version != s_tpiVersion80 || headerSize < s_tpiHeaderSize || begin > end ||
+        quint64(headerSize) + recordBytes > quint64(data.size()))
+    {
+        return false;
+    }
+
+    _data = data;
+    _headerSize = headerSize;
+    _begin = begin;
+    _end = end;
+    _offsets.fill(0, int(end - begin));
+    _typeNames.clear();
+
+    // The hash stream is optional, without it records are located by a scan
+    if (hashStream != 0xFFFF)
+        readIndexOffsets(msf, hashStream, indexOffsetsOffset, indexOffsetsLength);
+
+    return true;
+}
+
+void PdbTypeStream::clear()
+{
+    _data.clear();
+    _headerSize = 0;
+    _begin = 0;
+    _end = 0;
+    _offsets.clear();
+    _hints.clear();
+    _typeNames.clear();
+}
+
+PdbTypeRecord PdbTypeStream::record(quint32 typeIndex) const
+{
+    PdbTypeRecord result = { 0, 0, nullptr };
+
+    if (!contains(typeIndex))
+        return result;
+
+    quint32 offset = locate(typeIndex);
+    if (!offset)
+        return result;
+
+    const uchar* data = reinterpret_cast<const uchar*>(_data.constData()) + offset;
+    quint16 length = qFromLittleEndian<quint16>(data);
+    if (length < 2 || quint64(offset) + 2 + length > quint64(_data.size()))
+        return result;
+
+    result.kind = qFromLittleEndian<quint16>(data + 2);
+    result.length = length - 2;
+    result.data = data + 4;
+    return result;
+}
+
+QString PdbTypeStream::typeName(quint32 typeIndex) const
+{
+    return typeName(typeIndex, 0);
+}
+
+QString PdbTypeStream::recordName(const PdbTypeRecord& record) const
+{
+    if (!record.isValid())
+        return QString();
+
+    CvReader reader(record.data, record.end());
+
+    switch (record.kind)
+    {
+    case LF_CLASS:
+    case LF_STRUCTURE:
+    case LF_INTERFACE:
+        reader.skip(2 + 2 + 4 + 4 + 4);
+        reader.readNumeric();
+        return reader.readString();
+    case LF_UNION:
+        reader.skip(2 + 2 + 4);
+        reader.readNumeric();
+        return reader.readString();
+    case LF_ENUM:
+        reader.skip(2 + 2 + 4 + 4);
+        return reader.readString();
+    case LF_ARRAY:
+        reader.skip(4 + 4);
+        reader.readNumeric();
+        return reader.readString();
+    default:
+        return QString();
+    }
+}
+
+QString PdbTypeStream::stringId(quint32 id) const
+{
+    PdbTypeRecord item = record(id);
+    if (!item.isValid() || item.kind != LF_STRING_ID)
+        return QString();
+
+    CvReader reader(item.data, item.end());
+    quint32 substrings = reader.read32();
+    QString string = reader.readString();
+
+    // Long strings such as command lines are split into an LF_SUBSTR_LIST prefix
+    PdbTypeRecord list = record(substrings);
+    if (substrings == 0 || !list.isValid() || list.kind != LF_SUBSTR_LIST)
+        return string;
+
+    QString result;
+    CvReader parts(list.data, list.end());
+    quint32 count = parts.read32();
+    for (quint32 i = 0; i < count && parts.remaining() >= 4; ++i)
+    {
+        PdbTypeRecord part = record(parts.read32());
+        if (!part.isValid() || part.kind != LF_STRING_ID)
+            continue;
+
+        CvReader partReader(part.data, part.end());
+        partReader.skip(4);
+        result += partReader.readString();
+    }
+
+    return result + string;
+}
+
+QVector<PdbField> PdbTypeStream::fields(quint32 fieldList) const
+{
+    QVector<PdbField> result;
+
+    // Long field lists continue in another record through LF_INDEX
+    for (int depth = 0; fieldList && depth < s_maxTypeDepth; ++depth)
+    {
+        PdbTypeRecord list = record(fieldList);
+        if (!list.isValid() || list.kind != LF_FIELDLIST)
+            break;
+
+        fieldList = 0;
+        CvReader reader(list.data, list.end());
+
+        while (reader.remaining() >= 2)
+        {
+            PdbField field = { reader.read16(), 0, 0, QString() };
+
+            switch (field.kind)
+            {
+            case LF_MEMBER:
+                reader.skip(2);
+                field.typeIndex = reader.read32();
+                field.value = reader.readNumeric();
+                field.name = reader.readString();
+                result.append(field);
+                break;
+            case LF_STMEMBER:
+                reader.skip(2);
+                field.typeIndex = reader.read32();
+                field.name = reader.readString();
+                result.append(field);
+                break;
+            case LF_ENUMERATE:
+                reader.skip(2);
+                field.value = reader.readNumeric();
+                field.name = reader.readString();
+                result.append(field);
+                break;
+            case LF_BCLASS:
+                reader.skip(2 + 4);
+                reader.readNumeric();
+                break;
+            case LF_VBCLASS:
+            case LF_IVBCLASS:
+                reader.skip(2 + 4 + 4);
+                reader.readNumeric();
+                reader.readNumeric();
+                break;
+            case LF_VFUNCTAB:
+                reader.skip(2 + 4);
+                break;
+            case LF_INDEX:
+                reader.skip(2);
+                fieldList = reader.read32();
+                break;
+            case LF_ONEMETHOD:
+            {
+                quint16 attributes = reader.read16();
+                reader.skip(4);
+                // Introducing virtuals carry their vtable offset
+                quint16 property = (attributes >> 2) & 0x7;
+                if (property == 4 || property == 6)
+                    reader.skip(4);
+                reader.readStringData();
+                break;
+            }
+            case LF_METHOD:
+                reader.skip(2 + 4);
+                reader.readStringData();
+                break;
+            case LF_NESTTYPE:
+                reader.skip(2 + 4);
+                reader.readStringData();
+                break;
+            default:
+                return result;
+            }
+
+            while (reader.remaining() > 0 && *reader.position() >= LF_PAD0)
+            {
+                // A pad byte counts itself, LF_PAD0 would never move on
+                int pad = *reader.position() & 0x0F;
+                if (pad == 0)
+                    return result;
+                reader.skip(pad);
+            }
+
+            if (!reader.isValid())
+                return result;
+        }
+    }
+
+    return result;
+}
+
+QString PdbTypeStream::basicTypeName(quint32 typeIndex)
+{
+    QString result;
+
+    switch (typeIndex & 0xFF)
+    {
+    case 0x00:
+        result = QStringLiteral("<no type>");
+        break;
+    case 0x03:
+        result = QStringLiteral("void");
+        break;
+    case 0x08:
+        result = QStringLiteral("HRESULT");
+        break;
+    case 0x10:
+    case 0x68:
+        result = QStringLiteral("signed char");
+        break;
+    case 0x20:
+    case 0x69:
+        result = QStringLiteral("unsigned char");
+        break;
+    case 0x70:
+        result = QStringLiteral("char");
+        break;
+    case 0x71:
+        result = QStringLiteral("wchar_t");
+        break;
+    case 0x7a:
+        result = QStringLiteral("char16_t");
+        break;
+    case 0x7b:
+        result = QStringLiteral("char32_t");
+        break;
+    case 0x7c:
+        result = QStringLiteral("char8_t");
+        break;
+    case 0x11:
+    case 0x72:
+        result = QStringLiteral("short");
+        break;
+    case 0x21:
+    case 0x73:
+        result = QStringLiteral("unsigned short");
+        break;
+    case 0x12:
+        result = QStringLiteral("long");
+        break;
+    case 0x22:
+        result = QStringLiteral("unsigned long");
+        break;
+    case 0x74:
+        result = QStringLiteral("int");
+        break;
+    case 0x75:
+        result = QStringLiteral("unsigned int");
+        break;
+    case 0x13:
+    case 0x76:
+        result = QStringLiteral("__int64");
+        break;
+    case 0x23:
+    case 0x77:
+        result = QStringLiteral("unsigned __int64");
+        break;
+    case 0x14:
+    case 0x78:
+        result = QStringLiteral("__int128");
+        break;
+    case 0x24:
+    case 0x79:
+        result = QStringLiteral("unsigned __int128");
+        break;
+    case 0x40:
+        result = QStringLiteral("float");
+        break;
+    case 0x41:
+        result = QStringLiteral("double");
+        break;
+    case 0x42:
+        result = QStringLiteral("long double");
+        break;
+    case 0x30:
+        result = QStringLiteral("bool");
+        break;
+    default:
+        return QString();
+    }
+
+    // Basic types carry their pointer mode in bits 8..10
+    if ((typeIndex >> 8) & 0x7)
+        result += QStringLiteral(" *");
+
+    return result;
+}
+
+bool PdbTypeStream::readIndexOffsets(const MsfFile& msf, int hashStream, qint32 offset, quint32 length)
+{
+    QByteArray hash = msf.stream(hashStream);
+    if (offset < 0 || quint64(offset) + length > quint64(hash.size()))
+        return false;
+
+    const uchar* data = reinterpret_cast<const uchar*>(hash.constData()) + offset;
+    CvReader reader(data, data + length);
+
+    quint32 recordBytes = quint32(_data.size()) - _headerSize;
+    quint32 previous = 0;
+
+    _hints.reserve(int(length / 8));
+    while (reader.remaining() >= 8)
+    {
+        quint32 typeIndex = reader.read32();
+        quint32 recordOffset = reader.read32();
+
+        if (!contains(typeIndex) || recordOffset >= recordBytes || typeIndex < previous)
+        {
+            _hints.clear();
+            return false;
+        }
+
+        _hints.append(qMakePair(typeIndex, recordOffset));
+        previous = typeIndex;
+    }
+
+    return true;
+}
+
+quint32 PdbTypeStream::locate(quint32 typeIndex) const
+{
+    int index = int(typeIndex - _begin);
+    if (_offsets.at(index))
+        return _offsets.at(index);
+
+    quint32 current = _begin;
+    quint32 offset = _headerSize;
+
+    auto hint = std::upper_bound(_hints.constBegin(), _hints.constEnd(), typeIndex,
+                                 [](quint32 value, const QPair<quint32, quint32>& pair)
+                                 { return value < pair.first; });
+
+    // Sequential scans find their predecessor already located
+    if (index > 0 && _offsets.at(index - 1))
+    {
+        current = typeIndex - 1;
+        offset = _offsets.at(index - 1);
+    }
+    else if (hint != _hints.constBegin())
+    {
+        --hint;
+        current = hint->first;
+        offset = _headerSize + hint->second;
+    }
+
+    const uchar* data = reinterpret_cast<const uchar*>(_data.constData());
+    quint32 size = quint32(_data.size());
+
+    for (; current <= typeIndex; ++current)
+    {
+        if (quint64(offset) + 4 > size)
+            return 0;
+
+        _offsets[int(current - _begin)] = offset;
+        offset += 2 + qFromLittleEndian<quint16>(data + offset);
+    }
+
+    return _offsets.at(index);
+}
+
+QString PdbTypeStream::typeName(quint32 typeIndex, int depth) const
+{
+    if (typeIndex < FirstTypeIndex)
+        return basicTypeName(typeIndex);
+
+    if (depth > s_maxTypeDepth)
+        return QString();
+
+    auto it = _typeNames.constFind(typeIndex);
+    if (it != _typeNames.constEnd())
+        return it.value();
+
+    return _typeNames.insert(typeIndex, formatTypeName(typeIndex, depth)).value();
+}
+
+QString PdbTypeStream::formatTypeName(quint32 typeIndex, int depth) const
+{
+    PdbTypeRecord type = record(typeIndex);
+    if (!type.isValid())
+        return QString();
+
+    CvReader reader(type.data, type.end());
+
+    switch (type.kind)
+    {
+    case LF_MODIFIER:
+    {
+        quint32 modified = reader.read32();
+        quint16 attributes = reader.read16();
+
+        QString result;
+        if (attributes & CV_MODATTR_CONST)
+            result += QStringLiteral("const ");
+        if (attributes & CV_MODATTR_VOLATILE)
+            result += QStringLiteral("volatile ");
+        if (attributes & CV_MODATTR_UNALIGNED)
+            result += QStringLiteral("__unaligned ");
+
+        return result + typeName(modified, depth + 1);
+    }
+    case LF_POINTER:
+    {
+        quint32 referent = reader.read32();
+        quint32 attributes = reader.read32();
+
+        QString result = typeName(referent, depth + 1);
+        if (result.isEmpty())
+            return QString();
+
+        switch ((attributes >> 5) & 0x7)
+        {
+        case 1:
+            result += QStringLiteral(" &");
+            break;
+        case 4:
+            result += QStringLiteral(" &&");
+            break;
+        default:
+            result += QStringLiteral(" *");
+            break;
+        }
+
+        if (attributes & 0x400)
+            result += QStringLiteral(" const");
+        if (attributes & 0x200)
+            result += QStringLiteral(" volatile");
+        if (attributes & 0x800)
+            result += QStringLiteral(" __unaligned");
+
+        return result;
+    }
+    case LF_PROCEDURE:
+    case LF_MFUNCTION:
+        return QStringLiteral("<function>");
+    case LF_ARRAY:
+    {
+        QString element = typeName(reader.read32(), depth + 1);
+        return element.isEmpty() ? QString() : element + QStringLiteral("[]");
+    }
+    case LF_BITFIELD:
+    {
+        QString base = typeName(reader.read32(), depth + 1);
+        return base + QStringLiteral(" : %1").arg(reader.read8());
+    }
+    case LF_CLASS:
+        return QStringLiteral("class ") + recordName(type);
+    case LF_STRUCTURE:
+        return QStringLiteral("struct ") + recordName(type);
+    case LF_UNION:
+        return QStringLiteral("union ") + recordName(type);
+    case LF_INTERFACE:
+        return QStringLiteral("interface ") + recordName(type);
+    case LF_ENUM:
+    {
+        QString name = recordName(type);
+        return QStringLiteral("enum ") + (name.isEmpty() ? QStringLiteral("<unnamed>") : name);
+    }
+    default:
+        return QString();
+    }
+}
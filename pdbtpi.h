@@ -0,0 +1,110 @@
+#ifndef PDBTPI_H
+#define PDBTPI_H
+
+
+#include <QByteArray>
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+class MsfFile;
+
+
+struct PdbTypeRecord
+{
+    quint16 kind;
+    quint16 length;
+    const uchar* data;
+
+    bool isValid() const { return (data != nullptr); }
+    const uchar* end() const { return data + length; }
+};
+
+
+struct PdbField
+{
+    quint16 kind;
+    quint32 typeIndex;
+    quint64 value;
+    QString name;
+};
+
+
+class PdbTypeStream
+{
+public:
+    enum
+    {
+        TpiStreamIndex = 2,
+        IpiStreamIndex = 4,
+        FirstTypeIndex = 0x1000
+    };
+
+public:
+    PdbTypeStream();
+
+    bool load(const MsfFile& msf, int streamIndex);
+    void clear();
+    bool isLoaded() const;
+
+    quint32 typeIndexBegin() const;
+    quint32 typeIndexEnd() const;
+    int typeCount() const;
+    bool contains(quint32 typeIndex) const;
+
+    PdbTypeRecord record(quint32 typeIndex) const;
+
+    QString typeName(quint32 typeIndex) const;
+    QString recordName(const PdbTypeRecord& record) const;
+    QString stringId(quint32 id) const;
+    QVector<PdbField> fields(quint32 fieldList) const;
+
+    static QString basicTypeName(quint32 typeIndex);
+
+private:
+    bool readIndexOffsets(const MsfFile& msf, int hashStream, qint32 offset, quint32 length);
+    quint32 locate(quint32 typeIndex) const;
+    QString typeName(quint32 typeIndex, int depth) const;
+    QString formatTypeName(quint32 typeIndex, int depth) const;
+
+private:
+    QByteArray _data;
+    quint32 _headerSize;
+    quint32 _begin;
+    quint32 _end;
+    // Record offsets are filled lazily, zero means not located yet
+    mutable QVector<quint32> _offsets;
+    QVector<QPair<quint32, quint32>> _hints;
+    // Formatted names keyed by type index, cv variants have their own LF_MODIFIER index
+    mutable QHash<quint32, QString> _typeNames;
+};
+
+
+inline bool PdbTypeStream::isLoaded() const
+{
+    return !_data.isEmpty();
+}
+
+inline quint32 PdbTypeStream::typeIndexBegin() const
+{
+    return _begin;
+}
+
+inline quint32 PdbTypeStream::typeIndexEnd() const
+{
+    return _end;
+}
+
+inline int PdbTypeStream::typeCount() const
+{
+    return int(_end - _begin);
+}
+
+inline bool PdbTypeStream::contains(quint32 typeIndex) const
+{
+    return (typeIndex >= _begin && typeIndex < _end);
+}
+
+
+#endif // PDBTPI_H
@@ -0,0 +1,132 @@
+#include "pefile.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+
+
+static const quint16 s_pe32Magic = 0x10b;
+static const quint16 s_pe64Magic = 0x20b;
+static const quint32 s_debugDirectory = 6;
+static const quint32 s_debugTypeCodeView = 2;
+static const quint32 s_rsdsSignature = 0x53445352;
+
+QString PeDebugInfo::pdbName() const
+{
+    int slash = qMax(pdbPath.lastIndexOf('\\'), pdbPath.lastIndexOf('/'));
+    return (slash >= 0) ? pdbPath.mid(slash + 1) : pdbPath;
+}
+
+QString PeDebugInfo::symbolStoreKey() const
+{
+    if (guid.size() != 16)
+        return QString();
+
+    const uchar* data = reinterpret_cast<const uchar*>(guid.constData());
+
+    QString result = QStringLiteral("%1%2%3")
+                     .arg(qFromLittleEndian<quint32>(data), 8, 16, QLatin1Char('0'))
+                     .arg(qFromLittleEndian<quint16>(data + 4), 4, 16, QLatin1Char('0'))
+                     .arg(qFromLittleEndian<quint16>(data + 6), 4, 16, QLatin1Char('0'));
+
+    for (int i = 8; i < 16; ++i)
+        result += QStringLiteral("%1").arg(uint(data[i]), 2, 16, QLatin1Char('0'));
+
+    return result.toUpper() + QString::number(age, 16).toUpper();
+}
+
+bool PeFile::isImage(const QString& fileName)
+{
+    QString suffix = QFileInfo(fileName).suffix();
+    return (suffix.compare("exe", Qt::CaseInsensitive) == 0 ||
+            suffix.compare("dll", Qt::CaseInsensitive) == 0 ||
+            suffix.compare("sys", Qt::CaseInsensitive) == 0);
+}
+
+bool PeFile::readDebugInfo(const QString& fileName, PeDebugInfo* info)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    qint64 size = file.size();
+    const uchar* data = (size >= 0x40) ? file.map(0, size) : nullptr;
+    if (!data)
+        return false;
+
+    auto inside = [size](quint64 offset, quint64 length)
+    {
+        return (offset + length <= quint64(size));
+    };
+
+    quint32 header = qFromLittleEndian<quint32>(data + 0x3c);
+    if (!inside(header, 24) || qFromLittleEndian<quint32>(data + header) != 0x00004550)
+        return false;
+
+    quint16 sectionCount = qFromLittleEndian<quint16>(data + header + 6);
+    quint16 optionalSize = qFromLittleEndian<quint16>(data + header + 20);
+    quint32 optional = header + 24;
+    if (!inside(optional, optionalSize) || optionalSize < 2)
+        return false;
+
+    quint16 magic = qFromLittleEndian<quint16>(data + optional);
+    quint32 directories = 0;
+    if (magic == s_pe32Magic)
+        directories = 96;
+    else if (magic == s_pe64Magic)
+        directories = 112;
+    else
+        return false;
+
+    if (optionalSize < directories + (s_debugDirectory + 1) * 8 ||
+        qFromLittleEndian<quint32>(data + optional + directories - 4) <= s_debugDirectory)
+    {
+        return false;
+    }
+
+    quint32 debugRva = qFromLittleEndian<quint32>(data + optional + directories + s_debugDirectory * 8);
+    quint32 debugSize = qFromLittleEndian<quint32>(data + optional + directories + s_debugDirectory * 8 + 4);
+
+    // The debug directory is addressed by RVA, map it through the section table
+    quint32 sections = optional + optionalSize;
+    quint64 debugOffset = 0;
+    for (quint16 i = 0; i < sectionCount && inside(sections + i * 40, 40); ++i)
+    {
+        const uchar* section = data + sections + i * 40;
+        quint32 virtualAddress = qFromLittleEndian<quint32>(section + 12);
+        quint32 rawSize = qFromLittleEndian<quint32>(section + 16);
+        quint32 rawOffset = qFromLittleEndian<quint32>(section + 20);
+
+        if (debugRva >= virtualAddress && debugRva - virtualAddress < rawSize)
+        {
+            debugOffset = quint64(rawOffset) + (debugRva - virtualAddress);
+            break;
+        }
+    }
+
+    if (!debugOffset || !inside(debugOffset, debugSize))
+        return false;
+
+    for (quint32 entry = 0; entry + 28 <= debugSize; entry += 28)
+    {
+        const uchar* directory = data + debugOffset + entry;
+        if (qFromLittleEndian<quint32>(directory + 12) != s_debugTypeCodeView)
+            continue;
+
+        quint32 length = qFromLittleEndian<quint32>(directory + 16);
+        quint32 offset = qFromLittleEndian<quint32>(directory + 24);
+        if (length < 25 || !inside(offset, length) ||
+            qFromLittleEndian<quint32>(data + offset) != s_rsdsSignature)
+        {
+            continue;
+        }
+
+        const char* path = reinterpret_cast<const char*>(data + offset + 24);
+        info->guid = QByteArray(reinterpret_cast<const char*>(data + offset + 4), 16);
+        info->age = qFromLittleEndian<quint32>(data + offset + 20);
+        info->pdbPath = QString::fromUtf8(path, int(qstrnlen(path, length - 24)));
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,30 @@
+#ifndef PEFILE_H
+#define PEFILE_H
+
+
+#include <QByteArray>
+#include <QString>
+
+
+// CodeView RSDS record from the debug directory of an image
+struct PeDebugInfo
+{
+    QString pdbPath;
+    QByteArray guid;
+    quint32 age;
+
+    QString pdbName() const;
+    // Directory name used by symbol stores, GUID followed by the age in hex
+    QString symbolStoreKey() const;
+};
+
+
+class PeFile
+{
+public:
+    static bool readDebugInfo(const QString& fileName, PeDebugInfo* info);
+    static bool isImage(const QString& fileName);
+};
+
+
+#endif // PEFILE_H
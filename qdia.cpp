@@ -1,54 +1,219 @@
 #include "qdia.h"
 
+#include "atomtable.h"
+
+#include <QAtomicInt>
 #include <QDebug>
 
-QVector<IDiaSymbol*> QDIA::findChildren(IDiaSymbol* parent, enum SymTagEnum symtag, const QString& name, DWORD compareFlags)
+static QAtomicInt s_live;
+static QAtomicInt s_peak;
+static QAtomicInt s_limit;
+static QAtomicInteger<qint64> s_fetched;
+static QAtomicInteger<qint64> s_propertyReads;
+static AtomTable* s_atoms = nullptr;
+
+static QString fromBstr(const wchar_t* string, int length)
 {
-    QVector<IDiaSymbol*> result;
+    // BSTRs are UTF-16 on Windows, the atom table can look them up in place
+    if (s_atoms)
+        return s_atoms->intern(reinterpret_cast<const QChar*>(string), length);
 
-    if (!parent)
-        return result;
+    return QString::fromWCharArray(string, length);
+}
 
-    CComPtr<IDiaEnumSymbols> enumerator;
+void QDIA::setAtomTable(AtomTable* atoms)
+{
+    s_atoms = atoms;
+}
 
-    if (FAILED(parent->findChildren(symtag, name.isEmpty() ? NULL : LPOLESTR(name.utf16()), compareFlags, &enumerator)))
-        return result;
+QDIA::Residency QDIA::residency()
+{
+    Residency result;
+    result.live = s_live.loadRelaxed();
+    result.peak = s_peak.loadRelaxed();
+    result.limit = s_limit.loadRelaxed();
+    result.fetched = s_fetched.loadRelaxed();
+    return result;
+}
 
-    LONG count = 0;
-    if (FAILED(enumerator->get_Count(&count)))
-        return result;
+void QDIA::setResidencyLimit(int limit)
+{
+    s_limit.storeRelaxed(qMax(0, limit));
+}
 
-    result.resize(count);
+void QDIA::resetResidencyPeak()
+{
+    s_peak.storeRelaxed(s_live.loadRelaxed());
+    s_fetched.storeRelaxed(0);
+}
 
-    ULONG retrieved = 0;
-    if (FAILED(enumerator->Next(count, result.data(), &retrieved)) || retrieved != count)
-        result.clear();
+void QDIA::acquired(int count)
+{
+    int live = s_live.fetchAndAddRelaxed(count) + count;
+    s_fetched.fetchAndAddRelaxed(count);
+
+    int peak = s_peak.loadRelaxed();
+    while (live > peak && !s_peak.testAndSetRelaxed(peak, live, peak))
+    {
+    }
+}
+
+void QDIA::released(int count)
+{
+    s_live.fetchAndSubRelaxed(count);
+}
+
+ULONG QDIA::batchSize()
+{
+    int limit = s_limit.loadRelaxed();
+    if (limit == 0)
+        return BatchSize;
+
+    // Always make progress, even when the callers already hold the whole budget
+    return ULONG(qBound(1, limit - s_live.loadRelaxed(), int(BatchSize)));
+}
+
+qint64 QDIA::propertyReads()
+{
+    return s_propertyReads.loadRelaxed();
+}
+
+void QDIA::resetPropertyReads()
+{
+    s_propertyReads.storeRelaxed(0);
+}
+
+void QDIA::propertiesRead(int count)
+{
+    s_propertyReads.fetchAndAddRelaxed(count);
+}
+
+QVector<QDiaPtr<IDiaSymbol> > QDIA::findChildren(IDiaSymbol* parent, enum SymTagEnum symtag, const QString& name, DWORD compareFlags)
+{
+    QVector<QDiaPtr<IDiaSymbol> > result;
+
+    forEachChild(parent, symtag, [&result](IDiaSymbol* symbol)
+    {
+        result.append(QDiaPtr<IDiaSymbol>::share(symbol));
+        return true;
+    }, name, compareFlags);
 
     return result;
 }
 
-QVector<IDiaSourceFile*> QDIA::findSourceFiles(IDiaSession* session, IDiaSymbol* parent)
+QVector<QDiaPtr<IDiaSourceFile> > QDIA::findSourceFiles(IDiaSession* session, IDiaSymbol* parent)
+{
+    QVector<QDiaPtr<IDiaSourceFile> > result;
+
+    forEachSourceFile(session, parent, [&result](IDiaSourceFile* sourceFile)
+    {
+        result.append(QDiaPtr<IDiaSourceFile>::share(sourceFile));
+        return true;
+    });
+
+    return result;
+}
+
+QDiaPtr<IDiaSymbol> QDIA::getSymbolById(IDiaSession* session, DWORD id)
+{
+    IDiaSymbol* symbol = nullptr;
+    if (!session || FAILED(session->symbolById(id, &symbol)))
+        return QDiaPtr<IDiaSymbol>();
+
+    return QDiaPtr<IDiaSymbol>(symbol);
+}
+
+template <typename Enumerator, typename Item, typename Visitor>
+static bool visitBatches(Enumerator* enumerator, const Visitor& visitor)
+{
+    Item* batch[QDIA::BatchSize];
+    ULONG retrieved = 0;
+    bool completed = true;
+
+    // Next returns S_FALSE with a short batch at the end
+    while (completed && SUCCEEDED(enumerator->Next(QDIA::batchSize(), batch, &retrieved)) && retrieved > 0)
+    {
+        QDIA::acquired(int(retrieved));
+
+        for (ULONG i = 0; i < retrieved; ++i)
+        {
+            if (completed)
+                completed = visitor(batch[i]);
+            batch[i]->Release();
+            QDIA::released(1);
+        }
+    }
+
+    return completed;
+}
+
+bool QDIA::forEachChild(IDiaSymbol* parent, enum SymTagEnum symtag, const SymbolVisitor& visitor, const QString& name, DWORD compareFlags)
+{
+    if (!parent)
+        return false;
+
+    CComPtr<IDiaEnumSymbols> enumerator;
+
+    if (FAILED(parent->findChildren(symtag, name.isEmpty() ? NULL : LPOLESTR(name.utf16()), compareFlags, &enumerator)) || !enumerator)
+        return false;
+
+    return visitBatches<IDiaEnumSymbols, IDiaSymbol>(enumerator, visitor);
+}
+
+bool QDIA::forEachSourceFile(IDiaSession* session, IDiaSymbol* parent, const SourceFileVisitor& visitor)
 {
-    QVector<IDiaSourceFile*> result;
     if (!session || !parent)
-        return result;
+        return false;
 
     CComPtr<IDiaEnumSourceFiles> enumerator;
 
-    if (FAILED(session->findFile(parent, NULL, nsNone, &enumerator)))
-        return result;
+    if (FAILED(session->findFile(parent, NULL, nsNone, &enumerator)) || !enumerator)
+        return false;
 
-    LONG count = 0;
-    if (FAILED(enumerator->get_Count(&count)))
-        return result;
+    return visitBatches<IDiaEnumSourceFiles, IDiaSourceFile>(enumerator, visitor);
+}
+
+bool QDIA::forEachLine(IDiaSession* session, DWORD rva, DWORD length, const LineVisitor& visitor)
+{
+    if (!session)
+        return false;
 
-    result.resize(count);
+    CComPtr<IDiaEnumLineNumbers> enumerator;
 
-    ULONG retrieved = 0;
-    if (FAILED(enumerator->Next(count, result.data(), &retrieved)) || retrieved != count)
-        result.clear();
+    if (FAILED(session->findLinesByRVA(rva, length, &enumerator)) || !enumerator)
+        return false;
 
-    return result;
+    return visitBatches<IDiaEnumLineNumbers, IDiaLineNumber>(enumerator, visitor);
+}
+
+bool QDIA::forEachSymbolByAddress(IDiaSession* session, const SymbolVisitor& visitor)
+{
+    if (!session)
+        return false;
+
+    CComPtr<IDiaEnumSymbolsByAddr> enumerator;
+    if (FAILED(session->getSymbolsByAddr(&enumerator)) || !enumerator)
+        return false;
+
+    // Positioning returns the first symbol, Next continues after it
+    IDiaSymbol* first = nullptr;
+    if (enumerator->symbolByAddr(1, 0, &first) != S_OK || !first)
+        return true;
+
+    QDiaPtr<IDiaSymbol> symbol(first);
+    if (!visitor(symbol))
+        return false;
+
+    return visitBatches<IDiaEnumSymbolsByAddr, IDiaSymbol>(enumerator, visitor);
+}
+
+QDiaPtr<IDiaSymbol> QDIA::findFunction(IDiaSession* session, DWORD rva)
+{
+    IDiaSymbol* symbol = nullptr;
+    if (!session || session->findSymbolByRVA(rva, SymTagFunction, &symbol) != S_OK)
+        return QDiaPtr<IDiaSymbol>();
+
+    return QDiaPtr<IDiaSymbol>(symbol);
 }
 
 QString QDIA::getFileName(IDiaSourceFile* sourceFile)
@@ -60,11 +225,95 @@ QString QDIA::getFileName(IDiaSourceFile* sourceFile)
 
     CComBSTR string;
     if (SUCCEEDED(sourceFile->get_fileName(&string)))
-        result = QString::fromWCharArray(BSTR(string), string.Length());
+        result = fromBstr(string, string.Length());
+
+    return result;
+}
+
+DWORD QDIA::getUniqueId(IDiaSourceFile* sourceFile)
+{
+    DWORD result = 0;
+
+    if (sourceFile)
+        sourceFile->get_uniqueId(&result);
 
     return result;
 }
 
+DWORD QDIA::getSymIndexId(IDiaSymbol* symbol)
+{
+    DWORD result = 0;
+
+    if (symbol)
+        symbol->get_symIndexId(&result);
+
+    return result;
+}
+
+bool QDIA::getSectionContributions(IDiaSession* session, ContributionIndex* index)
+{
+    index->clear();
+
+    if (!session)
+        return false;
+
+    CComPtr<IDiaEnumTables> tables;
+    if (FAILED(session->getEnumTables(&tables)))
+        return false;
+
+    CComPtr<IDiaEnumSectionContribs> enumerator;
+    CComPtr<IDiaTable> table;
+    ULONG fetched = 0;
+
+    while (!enumerator && SUCCEEDED(tables->Next(1, &table, &fetched)) && fetched == 1)
+    {
+        table->QueryInterface(__uuidof(IDiaEnumSectionContribs), reinterpret_cast<void**>(&enumerator));
+        table.Release();
+    }
+
+    if (!enumerator)
+        return false;
+
+    LONG count = 0;
+    if (SUCCEEDED(enumerator->get_Count(&count)))
+        index->reserve(count);
+
+    visitBatches<IDiaEnumSectionContribs, IDiaSectionContrib>(enumerator, [index](IDiaSectionContrib* item)
+    {
+        DWORD rva = 0;
+        DWORD length = 0;
+        DWORD compilandId = 0;
+        BOOL code = FALSE;
+        BOOL initializedData = FALSE;
+        BOOL uninitializedData = FALSE;
+        BOOL execute = FALSE;
+
+        item->get_relativeVirtualAddress(&rva);
+        item->get_length(&length);
+        item->get_compilandId(&compilandId);
+        item->get_code(&code);
+        item->get_initializedData(&initializedData);
+        item->get_uninitializedData(&uninitializedData);
+        item->get_execute(&execute);
+
+        quint32 characteristics = 0;
+        if (code)
+            characteristics |= ContributionIndex::Code;
+        if (initializedData)
+            characteristics |= ContributionIndex::InitializedData;
+        if (uninitializedData)
+            characteristics |= ContributionIndex::UninitializedData;
+        if (execute)
+            characteristics |= ContributionIndex::Execute;
+
+        index->add(rva, length, compilandId, characteristics);
+        return true;
+    });
+
+    index->build();
+    return true;
+}
+
 QString QDIA::getName(IDiaSymbol* symbol)
 {
     QString result;
@@ -74,7 +323,7 @@ QString QDIA::getName(IDiaSymbol* symbol)
 
     CComBSTR string;
     if (SUCCEEDED(symbol->get_name(&string)))
-        result = QString::fromWCharArray(BSTR(string), string.Length());
+        result = fromBstr(string, string.Length());
 
     return result;
 }
@@ -88,7 +337,7 @@ QString QDIA::getLibraryName(IDiaSymbol* symbol)
 
     CComBSTR string;
     if (SUCCEEDED(symbol->get_libraryName(&string)))
-        result = QString::fromWCharArray(BSTR(string), string.Length());
+        result = fromBstr(string, string.Length());
 
     return result;
 }
@@ -111,7 +360,7 @@ QVariant QDIA::getValue(IDiaSymbol* symbol)
     switch (value.vt)
     {
     case VT_BSTR:
-        result = QString::fromWCharArray(value.bstrVal, ::SysStringLen(value.bstrVal));
+        result = fromBstr(value.bstrVal, ::SysStringLen(value.bstrVal));
         break;
     case VT_I2:
         result = value.iVal;
@@ -156,15 +405,16 @@ QVariant QDIA::getValue(IDiaSymbol* symbol)
 
 QString QDIA::getEnvPath(IDiaSymbol* symbol)
 {
-    QVector<IDiaSymbol*> objects = QDIA::findChildren(symbol, SymTagCompilandEnv);
+    QString result;
 
-    for (int i = 0; i < objects.size(); ++i)
+    // Let DIA match the name instead of fetching every environment entry
+    forEachChild(symbol, SymTagCompilandEnv, [&result](IDiaSymbol* object)
     {
-        if (QDIA::getName(objects[i]) == QLatin1String("obj"))
-            return QDIA::getValue(objects[i]).toString();
-    }
+        result = getValue(object).toString();
+        return false;
+    }, QStringLiteral("obj"), nsfCaseSensitive);
 
-    return QString();
+    return result;
 }
 
 QString QDIA::getUndName(IDiaSymbol* symbol)
@@ -174,20 +424,23 @@ QString QDIA::getUndName(IDiaSymbol* symbol)
     if (!symbol)
         return result;
 
-    CComBSTR string;
-    if (SUCCEEDED(symbol->get_undecoratedName(&string)))
-    {
-        result = QString::fromWCharArray(BSTR(string), string.Length());
-    }
-    else
-    {
+    if (!readUndecoratedName(symbol, &result))
         result = getName(symbol);
-    }
 
     return result;
 }
 
-QString QDIA::getTypeInformation(IDiaSymbol* symbol)
+bool QDIA::readUndecoratedName(IDiaSymbol* symbol, QString* result)
+{
+    CComBSTR string;
+    if (!symbol || FAILED(symbol->get_undecoratedName(&string)))
+        return false;
+
+    *result = fromBstr(string, string.Length());
+    return true;
+}
+
+QString QDIA::getTypeInformation(IDiaSymbol* symbol, TypeNameCache* cache)
 {
     CComPtr<IDiaSymbol> typeSymbol = nullptr;
     DWORD tag;
@@ -198,34 +451,67 @@ QString QDIA::getTypeInformation(IDiaSymbol* symbol)
         return QString();
     }
 
-    QString result;
-    QString name = getName(typeSymbol);
+    BOOL isConst = FALSE;
+    BOOL isVolatile = FALSE;
+    BOOL isUnaligned = FALSE;
+    typeSymbol->get_constType(&isConst);
+    typeSymbol->get_volatileType(&isVolatile);
+    typeSymbol->get_unalignedType(&isUnaligned);
 
-    if (tag != SymTagPointerType)
+    if (tag == SymTagPointerType)
     {
-        BOOL flag;
-        if (SUCCEEDED(typeSymbol->get_constType(&flag)) && flag)
-            result += QStringLiteral("const ");
-        if (SUCCEEDED(typeSymbol->get_volatileType(&flag)) && flag)
-            result += QStringLiteral("volatile ");
-        if (SUCCEEDED(typeSymbol->get_unalignedType(&flag)) && flag)
-            result += QStringLiteral("__unaligned ");
+        // Only pointers recurse, so only they are worth a cache lookup;
+        // DIA may hand out the same index for a pointer and its cv variants
+        // so the cached name stops before the qualifiers.
+        QString result;
+        quint32 key = 0;
+        if (cache)
+        {
+            key = getSymIndexId(typeSymbol);
+            result = cache->value(key);
+        }
+
+        if (result.isEmpty())
+        {
+            result = getNameOfPointerType(typeSymbol, cache);
+            if (result.isEmpty())
+                return QString();
+            if (cache)
+                cache->insert(key, result);
+        }
+
+        if (isConst)
+            result += QStringLiteral(" const");
+        if (isVolatile)
+            result += QStringLiteral(" volatile");
+        if (isUnaligned)
+            result += QStringLiteral(" __unaligned");
+
+        return result;
     }
 
+    QString result;
+    if (isConst)
+        result += QStringLiteral("const ");
+    if (isVolatile)
+        result += QStringLiteral("volatile ");
+    if (isUnaligned)
+        result += QStringLiteral("__unaligned ");
+
     switch (tag)
     {
     case SymTagBaseType:
         result += getNameOfBasicType(typeSymbol);
         break;
-    case SymTagPointerType:
-        result += getNameOfPointerType(typeSymbol);
-        break;
     case SymTagTypedef:
-        result += name;
+        result += getName(typeSymbol);
         break;
     case SymTagEnum:
+    {
+        QString name = getName(typeSymbol);
         result += QStringLiteral("enum ") + (name.isEmpty() ? QStringLiteral("<unnamed>") : name);
         break;
+    }
     case SymTagFunctionType:
         result += QStringLiteral("<function>");
         break;
@@ -326,9 +612,9 @@ QString QDIA::getNameOfBasicType(IDiaSymbol* baseType)
     }
 }
 
-QString QDIA::getNameOfPointerType(IDiaSymbol* pointerType)
+QString QDIA::getNameOfPointerType(IDiaSymbol* pointerType, TypeNameCache* cache)
 {
-    QString result = getTypeInformation(pointerType);
+    QString result = getTypeInformation(pointerType, cache);
     if (result.isEmpty())
         return QString();
 
@@ -342,13 +628,6 @@ QString QDIA::getNameOfPointerType(IDiaSymbol* pointerType)
         result += " *";
     }
 
-    if (SUCCEEDED(pointerType->get_constType(&flag)) && flag)
-        result += " const";
-    if (SUCCEEDED(pointerType->get_volatileType(&flag)) && flag)
-        result += " volatile";
-    if (SUCCEEDED(pointerType->get_unalignedType(&flag)) && flag)
-        result += " __unaligned";
-
     return result;
 }
 
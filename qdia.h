@@ -7,30 +7,313 @@
 #include <atlbase.h>
 #include <atlcomcli.h>
 
+#include "contributionindex.h"
+
+#include <QHash>
 #include <QString>
 #include <QVector>
 #include <QVariant>
 
+#include <functional>
+
+
+class AtomTable;
+
+template <typename T>
+class QDiaPtr;
 
 class QDIA
 {
 public:
-    static QVector<IDiaSymbol*> findChildren(IDiaSymbol* parent, enum SymTagEnum symtag, const QString& name = QString(), DWORD compareFlags = nsNone);
-    static QVector<IDiaSourceFile*> findSourceFiles(IDiaSession* session, IDiaSymbol* parent);
+    enum { BatchSize = 256 };
+
+    // DIA objects currently referenced through QDIA, a non-zero limit shrinks
+    // enumeration batches so that live never grows past it
+    struct Residency
+    {
+        int live;
+        int peak;
+        int limit;
+        qint64 fetched;
+    };
+
+    // Visitors borrow the object, it is released once the visitor returns.
+    // Returning false stops the enumeration.
+    typedef std::function<bool (IDiaSymbol*)> SymbolVisitor;
+    typedef std::function<bool (IDiaSourceFile*)> SourceFileVisitor;
+    typedef std::function<bool (IDiaLineNumber*)> LineVisitor;
+
+    // Pointer type names of one session by symIndexId, without their own cv qualifiers
+    typedef QHash<quint32, QString> TypeNameCache;
+
+    enum Property
+    {
+        PropertyIndexId = 0x001,
+        PropertyTag = 0x002,
+        PropertyName = 0x004,
+        PropertyUndName = 0x008,
+        PropertyLibraryName = 0x010,
+        PropertyType = 0x020,
+        PropertyUdtKind = 0x040,
+        PropertyValue = 0x080,
+        PropertyRva = 0x100,
+        PropertyLength = 0x200
+    };
+
+    // Only the members selected by the snapshot mask are filled
+    struct Snapshot
+    {
+        DWORD symIndexId;
+        DWORD tag;
+        DWORD rva;
+        ULONGLONG length;
+        QString name;
+        QString undName;
+        QString libraryName;
+        QString type;
+        QString udtKind;
+        QVariant value;
+    };
+
+public:
+    static Residency residency();
+    static void setResidencyLimit(int limit);
+    static void resetResidencyPeak();
+    static void acquired(int count);
+    static void released(int count);
+    static ULONG batchSize();
+
+    // Strings returned by the accessors are interned here while set
+    static void setAtomTable(AtomTable* atoms);
+
+    // Properties read through snapshot() since the last reset
+    static qint64 propertyReads();
+    static void resetPropertyReads();
+
+    template <unsigned Mask>
+    static Snapshot snapshot(IDiaSymbol* symbol, TypeNameCache* cache = nullptr);
+
+    // Hold every match at once, prefer the forEach functions for large scopes
+    static QVector<QDiaPtr<IDiaSymbol> > findChildren(IDiaSymbol* parent, enum SymTagEnum symtag, const QString& name = QString(), DWORD compareFlags = nsNone);
+    static QVector<QDiaPtr<IDiaSourceFile> > findSourceFiles(IDiaSession* session, IDiaSymbol* parent);
+    static QDiaPtr<IDiaSymbol> getSymbolById(IDiaSession* session, DWORD id);
+    static bool forEachChild(IDiaSymbol* parent, enum SymTagEnum symtag, const SymbolVisitor& visitor, const QString& name = QString(), DWORD compareFlags = nsNone);
+    static bool forEachSourceFile(IDiaSession* session, IDiaSymbol* parent, const SourceFileVisitor& visitor);
+    static bool forEachLine(IDiaSession* session, DWORD rva, DWORD length, const LineVisitor& visitor);
+    // Sequential walk of the session's address map, cheaper than findChildren per scope
+    static bool forEachSymbolByAddress(IDiaSession* session, const SymbolVisitor& visitor);
+    static QDiaPtr<IDiaSymbol> findFunction(IDiaSession* session, DWORD rva);
     static QString getFileName(IDiaSourceFile* sourceFile);
+    static DWORD getUniqueId(IDiaSourceFile* sourceFile);
+    static DWORD getSymIndexId(IDiaSymbol* symbol);
+    static bool getSectionContributions(IDiaSession* session, ContributionIndex* index);
     static QString getName(IDiaSymbol* symbol);
     static QString getLibraryName(IDiaSymbol* symbol);
     static QVariant getValue(IDiaSymbol* symbol);
     static QString getEnvPath(IDiaSymbol* symbol);
     static QString getUndName(IDiaSymbol* symbol);
-    static QString getTypeInformation(IDiaSymbol* symbol);
+    static bool readUndecoratedName(IDiaSymbol* symbol, QString* result);
+    static QString getTypeInformation(IDiaSymbol* symbol, TypeNameCache* cache = nullptr);
     static QString getNameOfBasicType(IDiaSymbol* baseType);
-    static QString getNameOfPointerType(IDiaSymbol* pointerType);
+    static QString getNameOfPointerType(IDiaSymbol* pointerType, TypeNameCache* cache = nullptr);
     static QString getNameOfFunctionType(IDiaSymbol* functionType);
     static QString getNameOfUserType(IDiaSymbol* userType);
     static QString getEnumInformation(IDiaSymbol* symbol);
     static QString getSymbolTag(IDiaSymbol* symbol);
     static QString getUdtKind(IDiaSymbol* udt);
+
+private:
+    static void propertiesRead(int count);
+};
+
+
+template <unsigned Mask>
+QDIA::Snapshot QDIA::snapshot(IDiaSymbol* symbol, TypeNameCache* cache)
+{
+    Snapshot result = { 0, SymTagNull, 0, 0 };
+    if (!symbol)
+        return result;
+
+    // Mask is a constant, the compiler drops every branch that was not asked for
+    int reads = 0;
+
+    if (Mask & PropertyIndexId)
+    {
+        symbol->get_symIndexId(&result.symIndexId);
+        ++reads;
+    }
+    if (Mask & PropertyTag)
+    {
+        symbol->get_symTag(&result.tag);
+        ++reads;
+    }
+    if (Mask & PropertyRva)
+    {
+        symbol->get_relativeVirtualAddress(&result.rva);
+        ++reads;
+    }
+    if (Mask & PropertyLength)
+    {
+        symbol->get_length(&result.length);
+        ++reads;
+    }
+    if (Mask & PropertyName)
+    {
+        result.name = getName(symbol);
+        ++reads;
+    }
+    if (Mask & PropertyUndName)
+    {
+        // Symbols without a decorated name fall back to the plain one we may already have
+        if (!readUndecoratedName(symbol, &result.undName))
+        {
+            if (Mask & PropertyName)
+            {
+                result.undName = result.name;
+            }
+            else
+            {
+                result.undName = getName(symbol);
+                ++reads;
+            }
+        }
+        ++reads;
+    }
+    if (Mask & PropertyLibraryName)
+    {
+        result.libraryName = getLibraryName(symbol);
+        ++reads;
+    }
+    if (Mask & PropertyType)
+    {
+        result.type = getTypeInformation(symbol, cache);
+        ++reads;
+    }
+    if (Mask & PropertyUdtKind)
+    {
+        result.udtKind = getUdtKind(symbol);
+        ++reads;
+    }
+    if (Mask & PropertyValue)
+    {
+        result.value = getValue(symbol);
+        ++reads;
+    }
+
+    propertiesRead(reads);
+    return result;
+}
+
+
+// Owning reference to a DIA object, counted in QDIA::residency()
+template <typename T>
+class QDiaPtr
+{
+public:
+    QDiaPtr();
+    explicit QDiaPtr(T* object);
+    QDiaPtr(const QDiaPtr& other);
+    QDiaPtr(QDiaPtr&& other);
+    ~QDiaPtr();
+
+    QDiaPtr& operator=(QDiaPtr other);
+
+    // Takes an additional reference to a borrowed object
+    static QDiaPtr share(T* object);
+
+    T* get() const;
+    T* operator->() const;
+    operator T*() const;
+
+    void reset();
+
+private:
+    T* _object;
 };
 
+
+template <typename T>
+inline QDiaPtr<T>::QDiaPtr()
+    : _object(nullptr)
+{
+}
+
+// Adopts a reference the caller already owns
+template <typename T>
+inline QDiaPtr<T>::QDiaPtr(T* object)
+    : _object(object)
+{
+    if (_object)
+        QDIA::acquired(1);
+}
+
+template <typename T>
+inline QDiaPtr<T>::QDiaPtr(const QDiaPtr& other)
+    : _object(other._object)
+{
+    if (_object)
+    {
+        _object->AddRef();
+        QDIA::acquired(1);
+    }
+}
+
+template <typename T>
+inline QDiaPtr<T>::QDiaPtr(QDiaPtr&& other)
+    : _object(other._object)
+{
+    other._object = nullptr;
+}
+
+template <typename T>
+inline QDiaPtr<T>::~QDiaPtr()
+{
+    reset();
+}
+
+template <typename T>
+inline QDiaPtr<T>& QDiaPtr<T>::operator=(QDiaPtr other)
+{
+    qSwap(_object, other._object);
+    return *this;
+}
+
+template <typename T>
+inline QDiaPtr<T> QDiaPtr<T>::share(T* object)
+{
+    if (object)
+        object->AddRef();
+
+    return QDiaPtr(object);
+}
+
+template <typename T>
+inline T* QDiaPtr<T>::get() const
+{
+    return _object;
+}
+
+template <typename T>
+inline T* QDiaPtr<T>::operator->() const
+{
+    return _object;
+}
+
+template <typename T>
+inline QDiaPtr<T>::operator T*() const
+{
+    return _object;
+}
+
+template <typename T>
+inline void QDiaPtr<T>::reset()
+{
+    if (_object)
+    {
+        _object->Release();
+        _object = nullptr;
+        QDIA::released(1);
+    }
+}
+
 #endif // QDIA_H
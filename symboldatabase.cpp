@@ -0,0 +1,173 @@
+#include "symboldatabase.h"
+
+#include <QHash>
+
+
+SymbolDatabase::SymbolDatabase()
+    : _loadMode(AddressSweep)
+{
+}
+
+bool SymbolDatabase::load(SymbolProvider* provider, const Progress& progress)
+{
+    clear();
+
+    auto report = [&progress](Phase phase, int done, int total, bool finished)
+    {
+        if (progress)
+            progress(phase, done, total, finished);
+    };
+
+    report(Contributions, 0, 0, false);
+    provider->sectionContributions(&_contributions);
+    report(Contributions, _contributions.count(), _contributions.count(), true);
+
+    QVector<SymbolCompiland> compilands = provider->compilands();
+    _modules.resize(compilands.size());
+    for (int i = 0; i < compilands.size(); ++i)
+    {
+        _modules[i].compiland = compilands.at(i);
+        _libraries.add(compilands.at(i), i, _contributions);
+    }
+
+    // Providers search a name filter per compiland, the sweep would have to check every symbol
+    bool swept = false;
+    if (_loadMode == AddressSweep && provider->filter().isEmpty())
+    {
+        report(Addresses, 0, 0, false);
+        swept = sweepAddresses(provider);
+        report(Addresses, _addresses.count(), _addresses.count(), true);
+    }
+
+    report(Modules, 0, compilands.size(), false);
+    for (int i = 0; i < compilands.size(); ++i)
+    {
+        if (provider->isCancelled())
+        {
+            // Modules read since the last batch are reported, so that they are kept
+            report(Modules, i, compilands.size(), false);
+            return false;
+        }
+
+        SymbolModule& module = _modules[i];
+        module.typedefs = provider->typedefs(module.compiland.id);
+        if (!swept)
+            module.functions = provider->functions(module.compiland.id);
+        module.sourceFiles = provider->sourceFiles(module.compiland.id);
+
+        if ((i + 1) % ModuleBatch == 0 || i + 1 == compilands.size())
+            report(Modules, i + 1, compilands.size(), i + 1 == compilands.size());
+    }
+
+    report(Typedefs, 0, 0, false);
+    _typedefs = provider->typedefs(SymbolProvider::GlobalScope);
+    if (provider->isCancelled())
+        return false;
+    report(Typedefs, _typedefs.size(), _typedefs.size(), true);
+
+    report(Enums, 0, 0, false);
+    _enums = provider->enums();
+    if (provider->isCancelled())
+        return false;
+    report(Enums, _enums.size(), _enums.size(), true);
+
+    report(UserTypes, 0, 0, false);
+    _userTypes = provider->userTypes();
+    if (provider->isCancelled())
+        return false;
+    report(UserTypes, _userTypes.size(), _userTypes.size(), true);
+
+    return true;
+}
+
+void SymbolDatabase::clear()
+{
+    _addresses.clear();
+    _contributions.clear();
+    _modules.clear();
+    _libraries.clear();
+    _typedefs.clear();
+    _enums.clear();
+    _userTypes.clear();
+}
+
+void SymbolDatabase::setContributions(const ContributionIndex& contributions)
+{
+    _contributions = contributions;
+    _libraries.recount(_contributions);
+}
+
+void SymbolDatabase::setAddresses(const AddressMap& addresses)
+{
+    _addresses = addresses;
+}
+
+void SymbolDatabase::appendModules(const QVector<SymbolModule>& modules)
+{
+    int first = _modules.size();
+    _modules += modules;
+
+    for (int i = 0; i < modules.size(); ++i)
+        _libraries.add(modules.at(i).compiland, first + i, _contributions);
+}
+
+void SymbolDatabase::setTypedefs(const QVector<SymbolTypedef>& typedefs)
+{
+    _typedefs = typedefs;
+}
+
+void SymbolDatabase::setEnums(const QVector<SymbolEnum>& enums)
+{
+    _enums = enums;
+}
+
+void SymbolDatabase::setUserTypes(const QVector<SymbolUserType>& userTypes)
+{
+    _userTypes = userTypes;
+}
+
+bool SymbolDatabase::sweepAddresses(SymbolProvider* provider)
+{
+    // Without contributions the sweep cannot tell which compiland owns a function
+    if (_contributions.isEmpty())
+        return false;
+
+    bool completed = provider->visitAddresses([this](const SymbolAddress& address)
+    {
+        _addresses.append(address);
+        return true;
+    });
+    _addresses.build();
+
+    if (!completed || _addresses.isEmpty())
+    {
+        _addresses.clear();
+        return false;
+    }
+
+    QHash<quint32, int> moduleIndex;
+    moduleIndex.reserve(_modules.size());
+    for (int i = 0; i < _modules.size(); ++i)
+        moduleIndex.insert(_modules.at(i).compiland.id, i);
+
+    // Hand each function to the compiland whose contribution holds its address
+    for (int i = 0; i < _addresses.count(); ++i)
+    {
+        const AddressRecord& record = _addresses.at(i);
+        if (record.kind != SymbolAddress::Function)
+            continue;
+
+        int contribution = _contributions.find(record.rva);
+        if (contribution < 0)
+            continue;
+
+        auto it = moduleIndex.constFind(_contributions.at(contribution).compiland);
+        if (it == moduleIndex.constEnd())
+            continue;
+
+        SymbolFunction function = { _addresses.name(record), record.rva };
+        _modules[it.value()].functions.append(function);
+    }
+
+    return true;
+}
@@ -0,0 +1,143 @@
+#ifndef SYMBOLDATABASE_H
+#define SYMBOLDATABASE_H
+
+
+#include "addressmap.h"
+#include "contributionindex.h"
+#include "libraryindex.h"
+#include "symbolprovider.h"
+
+#include <QVector>
+
+#include <functional>
+
+
+struct SymbolModule
+{
+    SymbolCompiland compiland;
+    QVector<SymbolTypedef> typedefs;
+    QVector<SymbolFunction> functions;
+    QVector<SymbolSourceFile> sourceFiles;
+};
+
+
+// Everything the docks show, read from a provider in a single pass so that
+// each view is built from memory instead of querying the provider again
+class SymbolDatabase
+{
+public:
+    enum LoadMode
+    {
+        // Function lists are filled from one address-ordered sweep of the image
+        AddressSweep,
+        // Function lists are queried compiland by compiland
+        PerCompiland
+    };
+
+    enum Phase
+    {
+        Contributions,
+        Addresses,
+        Modules,
+        Typedefs,
+        Enums,
+        UserTypes,
+        PhaseCount
+    };
+
+    enum { ModuleBatch = 64 };
+
+    // Called when a phase starts and with finished set once its records are
+    // complete, total is 0 while the size of a phase is unknown. Modules are
+    // reported every ModuleBatch compilands.
+    using Progress = std::function<void (Phase phase, int done, int total, bool finished)>;
+
+public:
+    SymbolDatabase();
+
+    void setLoadMode(LoadMode mode);
+    LoadMode loadMode() const;
+
+    // Returns false when the provider was cancelled, the data read so far is kept
+    bool load(SymbolProvider* provider, const Progress& progress = Progress());
+    void clear();
+
+    // Filled piece by piece while another database is loaded on a worker thread
+    void setContributions(const ContributionIndex& contributions);
+    void setAddresses(const AddressMap& addresses);
+    void appendModules(const QVector<SymbolModule>& modules);
+    void setTypedefs(const QVector<SymbolTypedef>& typedefs);
+    void setEnums(const QVector<SymbolEnum>& enums);
+    void setUserTypes(const QVector<SymbolUserType>& userTypes);
+
+    const AddressMap& addresses() const;
+    const ContributionIndex& contributions() const;
+    const QVector<SymbolModule>& modules() const;
+    // Modules grouped by library, kept up to date as modules are added
+    const LibraryIndex& libraries() const;
+    const QVector<SymbolTypedef>& typedefs() const;
+    const QVector<SymbolEnum>& enums() const;
+    const QVector<SymbolUserType>& userTypes() const;
+
+private:
+    bool sweepAddresses(SymbolProvider* provider);
+
+private:
+    LoadMode _loadMode;
+    AddressMap _addresses;
+    ContributionIndex _contributions;
+    QVector<SymbolModule> _modules;
+    LibraryIndex _libraries;
+    QVector<SymbolTypedef> _typedefs;
+    QVector<SymbolEnum> _enums;
+    QVector<SymbolUserType> _userTypes;
+};
+
+
+inline void SymbolDatabase::setLoadMode(LoadMode mode)
+{
+    _loadMode = mode;
+}
+
+inline SymbolDatabase::LoadMode SymbolDatabase::loadMode() const
+{
+    return _loadMode;
+}
+
+inline const AddressMap& SymbolDatabase::addresses() const
+{
+    return _addresses;
+}
+
+inline const ContributionIndex& SymbolDatabase::contributions() const
+{
+    return _contributions;
+}
+
+inline const QVector<SymbolModule>& SymbolDatabase::modules() const
+{
+    return _modules;
+}
+
+inline const LibraryIndex& SymbolDatabase::libraries() const
+{
+    return _libraries;
+}
+
+inline const QVector<SymbolTypedef>& SymbolDatabase::typedefs() const
+{
+    return _typedefs;
+}
+
+inline const QVector<SymbolEnum>& SymbolDatabase::enums() const
+{
+    return _enums;
+}
+
+inline const QVector<SymbolUserType>& SymbolDatabase::userTypes() const
+{
+    return _userTypes;
+}
+
+
+#endif // SYMBOLDATABASE_H
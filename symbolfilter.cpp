@@ -0,0 +1,75 @@
+#include "symbolfilter.h"
+
+
+SymbolFilter::SymbolFilter()
+    : _syntax(FixedString)
+    , _caseSensitivity(Qt::CaseInsensitive)
+{
+}
+
+SymbolFilter::SymbolFilter(const QString& pattern, Syntax syntax, Qt::CaseSensitivity caseSensitivity)
+    : _pattern(pattern)
+    , _syntax(syntax)
+    , _caseSensitivity(caseSensitivity)
+{
+    if (_pattern.isEmpty())
+        return;
+
+    QString expression;
+    if (_syntax == RegularExpression)
+    {
+        expression = _pattern;
+    }
+    else
+    {
+        expression = QRegularExpression::escape(_pattern);
+        if (_syntax == Wildcard)
+        {
+            expression.replace(QStringLiteral("\\*"), QStringLiteral(".*"));
+            expression.replace(QStringLiteral("\\?"), QStringLiteral("."));
+        }
+        expression = QRegularExpression::anchoredPattern(expression);
+    }
+
+    QRegularExpression::PatternOptions options = QRegularExpression::DontCaptureOption;
+    if (_caseSensitivity == Qt::CaseInsensitive)
+        options |= QRegularExpression::CaseInsensitiveOption;
+
+    _expression.setPattern(expression);
+    _expression.setPatternOptions(options);
+    _expression.optimize();
+}
+
+SymbolFilter SymbolFilter::fromUserPattern(const QString& pattern, Qt::CaseSensitivity caseSensitivity)
+{
+    QString trimmed = pattern.trimmed();
+
+    if (trimmed.size() > 1 && trimmed.startsWith(QLatin1Char('/')) && trimmed.endsWith(QLatin1Char('/')))
+        return SymbolFilter(trimmed.mid(1, trimmed.size() - 2), RegularExpression, caseSensitivity);
+
+    if (trimmed.contains(QLatin1Char('*')) || trimmed.contains(QLatin1Char('?')))
+        return SymbolFilter(trimmed, Wildcard, caseSensitivity);
+
+    return SymbolFilter(trimmed, FixedString, caseSensitivity);
+}
+
+bool SymbolFilter::isValid() const
+{
+    return (isEmpty() || _expression.isValid());
+}
+
+bool SymbolFilter::matches(const QString& name) const
+{
+    if (isEmpty())
+        return true;
+
+    return _expression.match(name).hasMatch();
+}
+
+QString SymbolFilter::toString() const
+{
+    if (_syntax == RegularExpression)
+        return QLatin1Char('/') + _pattern + QLatin1Char('/');
+
+    return _pattern;
+}
@@ -0,0 +1,69 @@
+#ifndef SYMBOLFILTER_H
+#define SYMBOLFILTER_H
+
+
+#include <QRegularExpression>
+#include <QString>
+
+
+// Name pattern restricting which symbols a provider loads. Wildcards use
+// * and ? like DIA's name search, so providers backed by DIA can hand
+// fixed strings and wildcards to findChildren and only check regular
+// expressions themselves. The native provider looks fixed strings up in
+// the PDB's name hashes.
+class SymbolFilter
+{
+public:
+    enum Syntax
+    {
+        FixedString,
+        Wildcard,
+        RegularExpression
+    };
+
+public:
+    SymbolFilter();
+    SymbolFilter(const QString& pattern, Syntax syntax, Qt::CaseSensitivity caseSensitivity = Qt::CaseInsensitive);
+
+    // "/expression/" is a regular expression, a pattern with * or ? a wildcard
+    static SymbolFilter fromUserPattern(const QString& pattern, Qt::CaseSensitivity caseSensitivity = Qt::CaseInsensitive);
+
+    bool isEmpty() const;
+    bool isValid() const;
+    const QString& pattern() const;
+    Syntax syntax() const;
+    Qt::CaseSensitivity caseSensitivity() const;
+
+    bool matches(const QString& name) const;
+    QString toString() const;
+
+private:
+    QString _pattern;
+    Syntax _syntax;
+    Qt::CaseSensitivity _caseSensitivity;
+    QRegularExpression _expression;
+};
+
+
+inline bool SymbolFilter::isEmpty() const
+{
+    return _pattern.isEmpty();
+}
+
+inline const QString& SymbolFilter::pattern() const
+{
+    return _pattern;
+}
+
+inline SymbolFilter::Syntax SymbolFilter::syntax() const
+{
+    return _syntax;
+}
+
+inline Qt::CaseSensitivity SymbolFilter::caseSensitivity() const
+{
+    return _caseSensitivity;
+}
+
+
+#endif // SYMBOLFILTER_H
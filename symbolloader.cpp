@@ -0,0 +1,143 @@
+#include "symbolloader.h"
+
+#include <QThread>
+
+
+SymbolLoader::SymbolLoader(QObject* parent)
+    : QObject(parent)
+    , _thread(nullptr)
+    , _provider(nullptr)
+    , _generation(0)
+{
+}
+
+SymbolLoader::~SymbolLoader()
+{
+    stop();
+}
+
+void SymbolLoader::start(SymbolProvider* provider, SymbolDatabase::LoadMode mode)
+{
+    stop();
+
+    _provider = provider;
+    _provider->resetCancel();
+
+    int generation = ++_generation;
+    _thread = QThread::create([this, provider, mode, generation]()
+    {
+        run(provider, mode, generation);
+    });
+    _thread->start();
+}
+
+void SymbolLoader::cancel()
+{
+    if (_provider)
+        _provider->cancel();
+}
+
+void SymbolLoader::stop()
+{
+    if (!_thread)
+        return;
+
+    cancel();
+    _thread->wait();
+    delete _thread;
+
+    _thread = nullptr;
+    _provider = nullptr;
+    ++_generation;
+}
+
+bool SymbolLoader::isRunning() const
+{
+    return (_thread && _thread->isRunning());
+}
+
+void SymbolLoader::run(SymbolProvider* provider, SymbolDatabase::LoadMode mode, int generation)
+{
+    SymbolDatabase database;
+    database.setLoadMode(mode);
+    int handed = 0;
+
+    // Runs on the worker, the records are copied out of the database before it moves on
+    bool completed = database.load(provider, [&](SymbolDatabase::Phase phase, int done, int total, bool finished)
+    {
+        post(generation, [this, phase, done, total]() { emit progress(phase, done, total); });
+
+        switch (phase)
+        {
+        case SymbolDatabase::Modules:
+            if (done > handed)
+            {
+                QVector<SymbolModule> modules = database.modules().mid(handed, done - handed);
+                post(generation, [this, modules]() { emit modulesLoaded(modules); });
+                handed = done;
+            }
+            return;
+        default:
+            break;
+        }
+
+        // Start reports carry nothing to hand over
+        if (!finished)
+            return;
+
+        switch (phase)
+        {
+        case SymbolDatabase::Contributions:
+        {
+            ContributionIndex contributions = database.contributions();
+            post(generation, [this, contributions]() { emit contributionsLoaded(contributions); });
+            break;
+        }
+        case SymbolDatabase::Addresses:
+        {
+            AddressMap addresses = database.addresses();
+            post(generation, [this, addresses]() { emit addressesLoaded(addresses); });
+            break;
+        }
+        case SymbolDatabase::Typedefs:
+        {
+            QVector<SymbolTypedef> typedefs = database.typedefs();
+            post(generation, [this, typedefs]() { emit typedefsLoaded(typedefs); });
+            break;
+        }
+        case SymbolDatabase::Enums:
+        {
+            QVector<SymbolEnum> enums = database.enums();
+            post(generation, [this, enums]() { emit enumsLoaded(enums); });
+            break;
+        }
+        case SymbolDatabase::UserTypes:
+        {
+            QVector<SymbolUserType> userTypes = database.userTypes();
+            post(generation, [this, userTypes]() { emit userTypesLoaded(userTypes); });
+            break;
+        }
+        default:
+            break;
+        }
+    });
+
+    post(generation, [this, completed]()
+    {
+        _thread->wait();
+        delete _thread;
+        _thread = nullptr;
+        _provider = nullptr;
+
+        emit finished(completed);
+    });
+}
+
+void SymbolLoader::post(int generation, const std::function<void ()>& function)
+{
+    QMetaObject::invokeMethod(this, [this, generation, function]()
+    {
+        if (generation == _generation)
+            function();
+    }, Qt::QueuedConnection);
+}
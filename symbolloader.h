@@ -0,0 +1,59 @@
+#ifndef SYMBOLLOADER_H
+#define SYMBOLLOADER_H
+
+
+#include "symboldatabase.h"
+
+#include <QObject>
+
+#include <functional>
+
+class QThread;
+
+
+// Loads a SymbolDatabase on a worker thread and hands it over piece by piece:
+// contributions and addresses first, then modules in batches as they are
+// read, then typedefs, enums and user types as each phase ends. All signals
+// are emitted on the thread that owns the loader.
+//
+// The provider is only used by the worker until finished() or stop(), it
+// must not be queried or closed before.
+class SymbolLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SymbolLoader(QObject* parent = nullptr);
+    ~SymbolLoader() override;
+
+    void start(SymbolProvider* provider, SymbolDatabase::LoadMode mode);
+    // Asks the worker to stop, finished(false) follows with what was loaded so far
+    void cancel();
+    // Cancels, waits for the worker and drops everything it has not handed over yet
+    void stop();
+
+    bool isRunning() const;
+
+signals:
+    void progress(int phase, int done, int total);
+    void contributionsLoaded(const ContributionIndex& contributions);
+    void addressesLoaded(const AddressMap& addresses);
+    void modulesLoaded(const QVector<SymbolModule>& modules);
+    void typedefsLoaded(const QVector<SymbolTypedef>& typedefs);
+    void enumsLoaded(const QVector<SymbolEnum>& enums);
+    void userTypesLoaded(const QVector<SymbolUserType>& userTypes);
+    void finished(bool completed);
+
+private:
+    void run(SymbolProvider* provider, SymbolDatabase::LoadMode mode, int generation);
+    void post(int generation, const std::function<void ()>& function);
+
+private:
+    QThread* _thread;
+    SymbolProvider* _provider;
+    // Results of an earlier load still queued when a new one starts are dropped
+    int _generation;
+};
+
+
+#endif // SYMBOLLOADER_H
@@ -0,0 +1,193 @@
+#include "symbolorder.h"
+
+#include "symboldatabase.h"
+#include "symboltreemodel.h"
+
+#include <QElapsedTimer>
+#include <QPair>
+#include <QSet>
+#include <QTextStream>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <random>
+
+
+QVector<int> SymbolOrder::typedefs(const QVector<SymbolTypedef>& typedefs)
+{
+    QVector<int> order;
+    order.reserve(typedefs.size());
+
+    QSet<QPair<QString, QString>> seen;
+    seen.reserve(typedefs.size());
+
+    for (int i = 0; i < typedefs.size(); ++i)
+    {
+        const SymbolTypedef& symbol = typedefs.at(i);
+        QPair<QString, QString> key(symbol.name, symbol.type);
+        if (seen.contains(key))
+            continue;
+
+        seen.insert(key);
+        order.append(i);
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&typedefs](int left, int right)
+    {
+        return typedefs.at(left).name < typedefs.at(right).name;
+    });
+
+    return order;
+}
+
+QVector<int> SymbolOrder::enums(const QVector<SymbolEnum>& enums)
+{
+    QVector<int> order(enums.size());
+    for (int i = 0; i < order.size(); ++i)
+        order[i] = i;
+
+    std::stable_sort(order.begin(), order.end(), [&enums](int left, int right)
+    {
+        return enums.at(left).name < enums.at(right).name;
+    });
+
+    return order;
+}
+
+QVector<int> SymbolOrder::userTypes(const QVector<SymbolUserType>& userTypes)
+{
+    QVector<int> order(userTypes.size());
+    for (int i = 0; i < order.size(); ++i)
+        order[i] = i;
+
+    // No kind is a prefix of another, so this matches comparing "kind name"
+    std::stable_sort(order.begin(), order.end(), [&userTypes](int left, int right)
+    {
+        const SymbolUserType& a = userTypes.at(left);
+        const SymbolUserType& b = userTypes.at(right);
+        int kind = QString::compare(a.kind, b.kind);
+        return (kind != 0) ? (kind < 0) : (a.name < b.name);
+    });
+
+    return order;
+}
+
+// Fills a dock the way MainWindow does and reads the sort column of every row
+// as a view scrolled through all of them would. Returns the elapsed time and
+// the number of rows found out of order.
+static qint64 populate(const SymbolDatabase& database, SymbolTreeModel::Kind kind, int* failures)
+{
+    SymbolTreeModel model(&database, QStringList({QStringLiteral("Name"), QStringLiteral("Type")}));
+    int column = (kind == SymbolTreeModel::Typedef) ? 1 : 0;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    model.beginBuild();
+    switch (kind)
+    {
+    case SymbolTreeModel::Typedef:
+        model.setTopLevel(kind, SymbolOrder::typedefs(database.typedefs()));
+        break;
+    case SymbolTreeModel::Enum:
+        model.setTopLevel(kind, SymbolOrder::enums(database.enums()));
+        break;
+    default:
+        model.setTopLevel(kind, SymbolOrder::userTypes(database.userTypes()));
+        break;
+    }
+    model.endBuild();
+
+    while (model.canFetchMore(QModelIndex()))
+        model.fetchMore(QModelIndex());
+
+    QString previous;
+    for (int row = 0; row < model.rowCount(); ++row)
+    {
+        QString current = model.data(model.index(row, column)).toString();
+        if (current < previous)
+            ++*failures;
+        previous = current;
+    }
+
+    return timer.nsecsElapsed();
+}
+
+int SymbolOrder::benchmark(int largest)
+{
+    static const char* const kinds[] = { "class", "struct", "union", "interface" };
+
+    QTextStream out(stdout);
+    if (largest < MinimumRows)
+    {
+        out << "At least " << MinimumRows << " rows are needed to measure scaling\n";
+        return 1;
+    }
+
+    out << "rows\ttypedefs ms\tenums ms\tudts ms\tns per n log2 n\n";
+
+    std::mt19937 random(20201);
+    int failures = 0;
+    double smallest = 0.0;
+    double normalized = 0.0;
+
+    for (int count = largest / 8; count <= largest; count *= 2)
+    {
+        QVector<SymbolTypedef> typedefs(count);
+        QVector<SymbolEnum> enums(count);
+        QVector<SymbolUserType> userTypes(count);
+
+        // Shuffled names with some repeats, so that ties and duplicates occur
+        for (int i = 0; i < count; ++i)
+        {
+            QString name = QStringLiteral("ns%1::symbol%2").arg(random() % 64).arg(random() % count);
+            typedefs[i].name = name;
+            typedefs[i].type = (i & 1) ? QStringLiteral("int") : QStringLiteral("unsigned int");
+            enums[i].name = name;
+            userTypes[i].kind = QLatin1String(kinds[random() % 4]);
+            userTypes[i].name = name;
+        }
+
+        SymbolDatabase database;
+        database.setTypedefs(typedefs);
+        database.setEnums(enums);
+        database.setUserTypes(userTypes);
+
+        // The best of a few runs, so that a stray pause does not read as growth
+        qint64 times[3] = { LLONG_MAX, LLONG_MAX, LLONG_MAX };
+        const SymbolTreeModel::Kind docks[3] = { SymbolTreeModel::Typedef, SymbolTreeModel::Enum,
+                                                 SymbolTreeModel::UserType };
+        for (int run = 0; run < BenchmarkRuns; ++run)
+        {
+            for (int dock = 0; dock < 3; ++dock)
+            {
+                int outOfOrder = 0;
+                times[dock] = qMin(times[dock], populate(database, docks[dock], &outOfOrder));
+                if (run == 0)
+                    failures += outOfOrder;
+            }
+        }
+
+        // Stays flat from row to row when the cost grows as n log n
+        double scale = count * std::log2(double(count));
+        normalized = double(times[0] + times[1] + times[2]) / scale;
+        if (smallest == 0.0)
+            smallest = normalized;
+
+        out << count << '\t' << times[0] / 1000000.0 << '\t' << times[1] / 1000000.0 << '\t'
+            << times[2] / 1000000.0 << '\t' << normalized << '\n';
+    }
+
+    if (failures)
+        out << failures << " rows out of order\n";
+
+    bool scales = (normalized <= smallest * ScalingTolerance);
+    if (!scales)
+    {
+        out << "Cost per n log2 n grew " << normalized / smallest << " times, more than "
+            << ScalingTolerance << " allowed\n";
+    }
+
+    return (failures || !scales) ? 1 : 0;
+}
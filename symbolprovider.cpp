@@ -0,0 +1,57 @@
+#include "symbolprovider.h"
+
+
+template <typename T>
+static SymbolProvider::Visitor<T> collector(QVector<T>* result)
+{
+    return [result](const T& item)
+    {
+        result->append(item);
+        return true;
+    };
+}
+
+SymbolProvider::SymbolProvider()
+    : _cancelled(0)
+{
+}
+
+QVector<SymbolTypedef> SymbolProvider::typedefs(quint32 scope)
+{
+    QVector<SymbolTypedef> result;
+    visitTypedefs(scope, collector(&result));
+    return result;
+}
+
+QVector<SymbolEnum> SymbolProvider::enums()
+{
+    QVector<SymbolEnum> result;
+    visitEnums(collector(&result));
+    return result;
+}
+
+QVector<SymbolUserType> SymbolProvider::userTypes()
+{
+    QVector<SymbolUserType> result;
+    visitUserTypes(collector(&result));
+    return result;
+}
+
+QVector<SymbolFunction> SymbolProvider::functions(quint32 compiland)
+{
+    QVector<SymbolFunction> result;
+    visitFunctions(compiland, collector(&result));
+    return result;
+}
+
+bool SymbolProvider::findLines(quint32 rva, quint32 size, QVector<SymbolLine>* lines)
+{
+    Q_UNUSED(size);
+
+    SymbolRange range;
+    if (!findFunction(rva, &range))
+        return false;
+
+    *lines = range.lines;
+    return true;
+}
@@ -0,0 +1,186 @@
+#ifndef SYMBOLPROVIDER_H
+#define SYMBOLPROVIDER_H
+
+
+#include "symbolfilter.h"
+
+#include <QAtomicInt>
+#include <QString>
+#include <QVector>
+
+#include <functional>
+
+class ContributionIndex;
+
+
+struct SymbolCompiland
+{
+    quint32 id;
+    QString name;
+    QString libraryName;
+    QString objectPath;
+};
+
+struct SymbolSourceFile
+{
+    quint32 id;
+    QString fileName;
+};
+
+struct SymbolTypedef
+{
+    QString name;
+    QString type;
+};
+
+struct SymbolMember
+{
+    QString name;
+    QString type;
+    QString value;
+};
+
+struct SymbolEnum
+{
+    QString name;
+    QString type;
+    QVector<SymbolMember> values;
+};
+
+struct SymbolUserType
+{
+    QString kind;
+    QString name;
+    QString type;
+    QVector<SymbolMember> members;
+};
+
+struct SymbolFunction
+{
+    QString name;
+    quint32 rva;
+};
+
+struct SymbolAddress
+{
+    enum Kind
+    {
+        Function,
+        Data,
+        Public,
+        Thunk,
+        Label,
+        Other
+    };
+
+    quint32 rva;
+    quint32 length;
+    Kind kind;
+    QString name;
+};
+
+struct SymbolLine
+{
+    quint32 rva;
+    quint32 length;
+    quint32 line;
+    QString fileName;
+};
+
+// A function's address range together with its line table, sorted by address
+struct SymbolRange
+{
+    quint32 rva;
+    quint32 size;
+    QString name;
+    QVector<SymbolLine> lines;
+};
+
+
+// Source of everything the docks show. Compiland ids are only meaningful to the
+// provider that returned them and match the compilands of its contribution index.
+//
+// The visit functions stream records one at a time and stop as soon as the
+// visitor returns false or cancel() is called, they return true only when
+// the enumeration ran to completion.
+//
+// A filter set before loading restricts the typedefs, enums, user types,
+// functions and addresses visited to those whose name matches it, compilands
+// and source files are always listed in full.
+class SymbolProvider
+{
+public:
+    enum { GlobalScope = 0xFFFFFFFF };
+
+    template <typename T>
+    using Visitor = std::function<bool (const T&)>;
+
+public:
+    SymbolProvider();
+    virtual ~SymbolProvider() {}
+
+    virtual bool open(const QString& fileName) = 0;
+    virtual void close() = 0;
+
+    virtual QVector<SymbolCompiland> compilands() = 0;
+    virtual QVector<SymbolSourceFile> sourceFiles(quint32 compiland) = 0;
+    virtual bool visitTypedefs(quint32 scope, const Visitor<SymbolTypedef>& visitor) = 0;
+    virtual bool visitEnums(const Visitor<SymbolEnum>& visitor) = 0;
+    virtual bool visitUserTypes(const Visitor<SymbolUserType>& visitor) = 0;
+    virtual bool visitFunctions(quint32 compiland, const Visitor<SymbolFunction>& visitor) = 0;
+    virtual bool sectionContributions(ContributionIndex* index) = 0;
+    virtual bool findFunction(quint32 rva, SymbolRange* result) = 0;
+    // Line table of a range already known, by default through findFunction()
+    virtual bool findLines(quint32 rva, quint32 size, QVector<SymbolLine>* lines);
+    // Every addressed symbol of the image in ascending address order
+    virtual bool visitAddresses(const Visitor<SymbolAddress>& visitor) = 0;
+
+    // One line summary of the resources used by the last load
+    virtual QString statistics() const { return QString(); }
+
+    QVector<SymbolTypedef> typedefs(quint32 scope);
+    QVector<SymbolEnum> enums();
+    QVector<SymbolUserType> userTypes();
+    QVector<SymbolFunction> functions(quint32 compiland);
+
+    void setFilter(const SymbolFilter& filter);
+    const SymbolFilter& filter() const;
+
+    // Safe to call from any thread while a visit is running
+    void cancel();
+    void resetCancel();
+    bool isCancelled() const;
+
+private:
+    SymbolFilter _filter;
+    QAtomicInt _cancelled;
+};
+
+
+inline void SymbolProvider::setFilter(const SymbolFilter& filter)
+{
+    _filter = filter;
+}
+
+inline const SymbolFilter& SymbolProvider::filter() const
+{
+    return _filter;
+}
+
+inline void SymbolProvider::cancel()
+{
+    _cancelled.storeRelaxed(1);
+}
+
+inline void SymbolProvider::resetCancel()
+{
+    _cancelled.storeRelaxed(0);
+}
+
+inline bool SymbolProvider::isCancelled() const
+{
+    return (_cancelled.loadRelaxed() != 0);
+}
+
+
+#endif // SYMBOLPROVIDER_H
@@ -0,0 +1,305 @@
+#include "symbolstore.h"
+
+#include "pdbfile.h"
+#include "pefile.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextStream>
+
+
+SymbolStore::SymbolStore()
+    : _dirty(false)
+    , _probes(0)
+{
+}
+
+void SymbolStore::setDirectories(const QStringList& directories)
+{
+    QVector<Store> stores;
+
+    for (const QString& directory : directories)
+    {
+        QString path = QDir::fromNativeSeparators(directory.trimmed());
+        if (path.isEmpty())
+            continue;
+
+        // Keep what is already known about stores that stay configured
+        Store store;
+        store.path = path;
+        for (int i = 0; i < _stores.size(); ++i)
+        {
+            if (_stores.at(i).path == path)
+            {
+                store = _stores.at(i);
+                break;
+            }
+        }
+        stores.append(store);
+    }
+
+    _stores = stores;
+    _negative.clear();
+    _dirty = true;
+}
+
+QStringList SymbolStore::directories() const
+{
+    QStringList result;
+    for (int i = 0; i < _stores.size(); ++i)
+        result << QDir::toNativeSeparators(_stores.at(i).path);
+
+    return result;
+}
+
+bool SymbolStore::loadIndex(const QString& fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+    Store* store = nullptr;
+
+    while (!stream.atEnd())
+    {
+        QStringList fields = stream.readLine().split(QLatin1Char('\t'));
+        if (fields.size() < 2)
+            continue;
+
+        const QString& kind = fields.at(0);
+        if (kind == QLatin1String("store"))
+        {
+            store = nullptr;
+            for (int i = 0; i < _stores.size(); ++i)
+            {
+                if (_stores.at(i).path == fields.at(1))
+                    store = &_stores[i];
+            }
+        }
+        else if (kind == QLatin1String("entry") && store)
+        {
+            QSet<QString>& keys = store->entries[fields.at(1).toLower()];
+            for (int i = 2; i < fields.size(); ++i)
+                keys.insert(fields.at(i));
+        }
+        else if (kind == QLatin1String("found") && fields.size() == 3)
+        {
+            _found.insert(fields.at(1), fields.at(2));
+        }
+        else if (kind == QLatin1String("miss") && fields.size() == 3)
+        {
+            qint64 expiry = fields.at(2).toLongLong();
+            if (expiry > now)
+                _negative.insert(fields.at(1), expiry);
+        }
+    }
+
+    _dirty = false;
+    return true;
+}
+
+bool SymbolStore::saveIndex(const QString& fileName)
+{
+    if (!_dirty)
+        return true;
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+
+    for (int i = 0; i < _stores.size(); ++i)
+    {
+        const Store& store = _stores.at(i);
+        stream << "store\t" << store.path << '\n';
+
+        for (auto it = store.entries.constBegin(); it != store.entries.constEnd(); ++it)
+        {
+            stream << "entry\t" << it.key();
+            for (const QString& key : it.value())
+                stream << '\t' << key;
+            stream << '\n';
+        }
+    }
+
+    for (auto it = _found.constBegin(); it != _found.constEnd(); ++it)
+        stream << "found\t" << it.key() << '\t' << it.value() << '\n';
+
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+    for (auto it = _negative.constBegin(); it != _negative.constEnd(); ++it)
+    {
+        if (it.value() > now)
+            stream << "miss\t" << it.key() << '\t' << it.value() << '\n';
+    }
+
+    stream.flush();
+    if (!file.commit())
+        return false;
+
+    _dirty = false;
+    return true;
+}
+
+void SymbolStore::rebuildIndex()
+{
+    for (int i = 0; i < _stores.size(); ++i)
+    {
+        Store& store = _stores[i];
+        store.entries.clear();
+        store.scanned.clear();
+
+        const QStringList names = QDir(store.path).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+        ++_probes;
+
+        for (const QString& name : names)
+            scanName(&store, name);
+    }
+
+    _negative.clear();
+    _dirty = true;
+}
+
+QString SymbolStore::locate(const QString& imageFileName)
+{
+    PeDebugInfo info;
+    if (!PeFile::readDebugInfo(imageFileName, &info))
+        return QString();
+
+    QString name = info.pdbName();
+    if (name.isEmpty())
+        return QString();
+
+    // Next to the image first, as debuggers do, then where the linker wrote it.
+    // Either may hold a PDB of another build, stores are laid out by key.
+    QString sibling = QFileInfo(imageFileName).absolutePath() + QLatin1Char('/') + name;
+    if (exists(sibling) && matches(sibling, info))
+        return sibling;
+
+    QString original = QDir::fromNativeSeparators(info.pdbPath);
+    if (original != sibling && QFileInfo(original).isAbsolute() && exists(original) && matches(original, info))
+        return original;
+
+    QString key = info.symbolStoreKey();
+    QString found = _found.value(lookupKey(name.toLower(), key.toUpper()));
+    if (!found.isEmpty() && exists(found) && matches(found, info))
+        return found;
+
+    return find(name, key);
+}
+
+QString SymbolStore::find(const QString& pdbName, const QString& key)
+{
+    QString lowerName = pdbName.toLower();
+    QString upperKey = key.toUpper();
+    QString miss = lookupKey(lowerName, upperKey);
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+
+    auto negative = _negative.constFind(miss);
+    if (negative != _negative.constEnd() && negative.value() > now)
+        return QString();
+
+    // The index is trusted first, a store's directory for this name is listed at most once a session
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (int i = 0; i < _stores.size(); ++i)
+        {
+            Store& store = _stores[i];
+
+            if (pass == 1)
+            {
+                if (store.scanned.contains(lowerName))
+                    continue;
+                scanName(&store, pdbName);
+            }
+
+            auto it = store.entries.find(lowerName);
+            if (it == store.entries.end() || !it.value().contains(upperKey))
+                continue;
+
+            QString path = store.path + QLatin1Char('/') + pdbName + QLatin1Char('/') +
+                           upperKey + QLatin1Char('/') + pdbName;
+            if (exists(path))
+                return path;
+
+            it.value().remove(upperKey);
+            _dirty = true;
+        }
+    }
+
+    _negative.insert(miss, now + NegativeLifetime);
+    _dirty = true;
+    return QString();
+}
+
+bool SymbolStore::isMissing(const QString& pdbName, const QString& key) const
+{
+    return _negative.value(lookupKey(pdbName.toLower(), key.toUpper())) > QDateTime::currentSecsSinceEpoch();
+}
+
+void SymbolStore::addFound(const QString& pdbName, const QString& key, const QString& fileName)
+{
+    QString lookup = lookupKey(pdbName.toLower(), key.toUpper());
+    _negative.remove(lookup);
+    _found.insert(lookup, QDir::fromNativeSeparators(fileName));
+    _dirty = true;
+}
+
+void SymbolStore::addMissing(const QString& pdbName, const QString& key)
+{
+    QString lookup = lookupKey(pdbName.toLower(), key.toUpper());
+    _found.remove(lookup);
+    _negative.insert(lookup, QDateTime::currentSecsSinceEpoch() + NegativeLifetime);
+    _dirty = true;
+}
+
+bool SymbolStore::exists(const QString& fileName)
+{
+    ++_probes;
+    return QFileInfo::exists(fileName);
+}
+
+bool SymbolStore::matches(const QString& fileName, const PeDebugInfo& info)
+{
+    QByteArray guid;
+    quint32 age = 0;
+
+    ++_probes;
+    if (!PdbFile::readSignature(fileName, &guid, &age))
+        return false;
+
+    return guid == info.guid && age == info.age;
+}
+
+void SymbolStore::scanName(Store* store, const QString& name)
+{
+    QString lowerName = name.toLower();
+    QSet<QString>& keys = store->entries[lowerName];
+    keys.clear();
+
+    const QStringList entries = QDir(store->path + QLatin1Char('/') + name)
+                                .entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    ++_probes;
+
+    for (const QString& entry : entries)
+        keys.insert(entry.toUpper());
+
+    if (keys.isEmpty())
+        store->entries.remove(lowerName);
+
+    store->scanned.insert(lowerName);
+    _dirty = true;
+}
+
+QString SymbolStore::lookupKey(const QString& name, const QString& key)
+{
+    return name + QLatin1Char('/') + key;
+}
@@ -0,0 +1,77 @@
+#ifndef SYMBOLSTORE_H
+#define SYMBOLSTORE_H
+
+
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+struct PeDebugInfo;
+
+
+// Finds PDBs in local symstore-layout directories (name/GUIDage/name).
+// What each store holds is kept in an index file, lookups that found
+// nothing are remembered for NegativeLifetime seconds so that opening the
+// same image again touches no directories at all. PDBs found elsewhere are
+// remembered by path.
+class SymbolStore
+{
+public:
+    enum { NegativeLifetime = 24 * 60 * 60 };
+
+public:
+    SymbolStore();
+
+    void setDirectories(const QStringList& directories);
+    QStringList directories() const;
+
+    bool loadIndex(const QString& fileName);
+    bool saveIndex(const QString& fileName);
+    void rebuildIndex();
+
+    // PDB matching an image, empty when neither the image's directory, the path
+    // recorded by the linker, an earlier search nor a store has one with the
+    // image's GUID and age
+    QString locate(const QString& imageFileName);
+    QString find(const QString& pdbName, const QString& key);
+
+    // True while a failed search for the PDB is remembered
+    bool isMissing(const QString& pdbName, const QString& key) const;
+    // Results of searches outside the stores, such as DIA's search path
+    void addFound(const QString& pdbName, const QString& key, const QString& fileName);
+    void addMissing(const QString& pdbName, const QString& key);
+
+    // Directory listings and file checks done since construction
+    int probes() const;
+
+private:
+    struct Store
+    {
+        QString path;
+        // Lower case PDB name to the keys present in the store
+        QHash<QString, QSet<QString>> entries;
+        QSet<QString> scanned;
+    };
+
+    bool exists(const QString& fileName);
+    bool matches(const QString& fileName, const PeDebugInfo& info);
+    void scanName(Store* store, const QString& name);
+    static QString lookupKey(const QString& name, const QString& key);
+
+private:
+    QVector<Store> _stores;
+    QHash<QString, qint64> _negative;
+    QHash<QString, QString> _found;
+    bool _dirty;
+    int _probes;
+};
+
+
+inline int SymbolStore::probes() const
+{
+    return _probes;
+}
+
+
+#endif // SYMBOLSTORE_H
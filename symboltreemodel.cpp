@@ -0,0 +1,536 @@
+#include "symboltreemodel.h"
+
+#include "symboldatabase.h"
+
+
+// Marks an index that is a plain row, the remaining bits are its parent node
+static const quintptr s_rowFlag = quintptr(1) << (sizeof(quintptr) * 8 - 1);
+
+static const char* const s_iconFiles[] =
+{
+    ":/images/file_extension_exe.png",
+    ":/images/books_stack.png",
+    ":/images/drive.png",
+    ":/images/folder.png",
+    ":/images/module.png",
+    ":/images/resources.png",
+    ":/images/file_extension_dll.png",
+    ":/images/page_error.png",
+    ":/images/database_green.png",
+    ":/images/math_functions.png",
+    ":/images/folder_page.png",
+    ":/images/token_lookaround.png",
+    ":/images/function.png",
+    ":/images/source_code.png",
+    ":/images/text_list_numbers.png",
+    ":/images/bullet_black.png",
+    ":/images/bricks.png",
+    ":/images/bricks_struct.png",
+    ":/images/token_group.png",
+    ":/images/token_match_character_literally.png"
+};
+
+static QString fileNameOf(const QString& path)
+{
+    int slash = qMax(path.lastIndexOf('\\'), path.lastIndexOf('/'));
+    return (slash >= 0) ? path.mid(slash + 1) : path;
+}
+
+SymbolTreeModel::SymbolTreeModel(const SymbolDatabase* database, const QStringList& header, QObject* parent)
+    : QAbstractItemModel(parent)
+    , _database(database)
+    , _header(header)
+    , _topLevel(Root)
+    , _building(false)
+{
+    Q_STATIC_ASSERT(sizeof(s_iconFiles) / sizeof(s_iconFiles[0]) == IconCount);
+
+    // One icon per kind of row, shared by every row that shows it
+    _icons.reserve(IconCount);
+    for (int i = 0; i < IconCount; ++i)
+        _icons.append(QIcon(s_iconFiles[i]));
+
+    clear();
+}
+
+void SymbolTreeModel::clear()
+{
+    beginResetModel();
+
+    _nodes.clear();
+    _labels.clear();
+    _order.clear();
+    _topLevel = Root;
+
+    Node root = { -1, 0, Root, -1, 0, QVector<int>() };
+    _nodes.append(root);
+
+    endResetModel();
+}
+
+void SymbolTreeModel::beginBuild()
+{
+    beginResetModel();
+    _building = true;
+}
+
+void SymbolTreeModel::endBuild()
+{
+    _building = false;
+    endResetModel();
+}
+
+int SymbolTreeModel::addGroup(int parent, int position, Kind kind, const QString& name,
+                              const QString& description)
+{
+    Label label = { name, description };
+    _labels.append(label);
+
+    return insertNode(parent, position, kind, _labels.size() - 1);
+}
+
+int SymbolTreeModel::addLibrary(int library)
+{
+    // The executable's own compilands come first
+    if (_database->libraries().at(library).executable)
+        return insertNode(RootNode, 0, Executable, library);
+
+    return insertNode(RootNode, -1, Library, library);
+}
+
+int SymbolTreeModel::addCompiland(int parent, int module)
+{
+    return insertNode(parent, -1, Compiland, module);
+}
+
+void SymbolTreeModel::setTopLevel(Kind kind, const QVector<int>& order)
+{
+    _topLevel = kind;
+    _order = order;
+}
+
+int SymbolTreeModel::childCount(int node) const
+{
+    return _nodes.at(node).children.size();
+}
+
+int SymbolTreeModel::child(int node, int row) const
+{
+    return _nodes.at(node).children.at(row);
+}
+
+QString SymbolTreeModel::name(int node) const
+{
+    const Node& item = _nodes.at(node);
+    if (item.kind == Compiland)
+        return fileNameOf(_database->modules().at(item.source).compiland.name);
+    if (item.kind == Executable || item.kind == Library)
+        return _database->libraries().at(item.source).name;
+
+    return _labels.at(item.source).name;
+}
+
+QModelIndex SymbolTreeModel::index(int row, int column, const QModelIndex& parent) const
+{
+    int node = nodeOf(parent);
+    if (node < 0 || row < 0 || column < 0 || column >= _header.size() || row >= shown(node))
+        return QModelIndex();
+
+    if (hasRowChildren(node))
+        return createIndex(row, column, s_rowFlag | quintptr(node));
+
+    return createIndex(row, column, quintptr(_nodes.at(node).children.at(row)));
+}
+
+QModelIndex SymbolTreeModel::parent(const QModelIndex& index) const
+{
+    if (!index.isValid())
+        return QModelIndex();
+
+    quintptr id = index.internalId();
+    int node = (id & s_rowFlag) ? int(id & ~s_rowFlag) : _nodes.at(int(id)).parent;
+    return indexOf(node);
+}
+
+int SymbolTreeModel::rowCount(const QModelIndex& parent) const
+{
+    int node = nodeOf(parent);
+    if (node < 0 || parent.column() > 0)
+        return 0;
+
+    return shown(node);
+}
+
+int SymbolTreeModel::columnCount(const QModelIndex& parent) const
+{
+    Q_UNUSED(parent);
+    return _header.size();
+}
+
+bool SymbolTreeModel::hasChildren(const QModelIndex& parent) const
+{
+    int node = nodeOf(parent);
+    if (node < 0 || parent.column() > 0)
+        return false;
+
+    // Unfetched children still have to show an expander
+    return (available(node) > 0);
+}
+
+bool SymbolTreeModel::canFetchMore(const QModelIndex& parent) const
+{
+    int node = nodeOf(parent);
+    return (node >= 0 && shown(node) < available(node));
+}
+
+void SymbolTreeModel::fetchMore(const QModelIndex& parent)
+{
+    int node = nodeOf(parent);
+    if (node < 0)
+        return;
+
+    int first = shown(node);
+    int count = qMin(int(FetchBatch), available(node) - first);
+    if (count <= 0)
+        return;
+
+    beginInsertRows(parent, first, first + count - 1);
+
+    if (hasRowChildren(node))
+    {
+        _nodes[node].fetched += count;
+    }
+    else
+    {
+        for (int row = first; row < first + count; ++row)
+        {
+            const Node& item = _nodes.at(node);
+            if (item.kind == Compiland)
+                addNode(node, -1, groupAt(item.source, row), item.source);
+            else
+                addNode(node, -1, _topLevel, _order.at(row));
+        }
+    }
+
+    endInsertRows();
+}
+
+QVariant SymbolTreeModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+
+    quintptr id = index.internalId();
+    if (id & s_rowFlag)
+        return rowData(int(id & ~s_rowFlag), index.row(), index.column(), role);
+
+    return nodeData(int(id), index.column(), role);
+}
+
+QVariant SymbolTreeModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole || section < 0 || section >= _header.size())
+        return QVariant();
+
+    return _header.at(section);
+}
+
+int SymbolTreeModel::insertNode(int parent, int position, Kind kind, int source)
+{
+    if (_building)
+        return addNode(parent, position, kind, source);
+
+    int count = _nodes.at(parent).children.size();
+    if (position < 0 || position > count)
+        position = count;
+
+    beginInsertRows(indexOf(parent), position, position);
+    int id = addNode(parent, position, kind, source);
+    endInsertRows();
+
+    return id;
+}
+
+int SymbolTreeModel::addNode(int parent, int position, Kind kind, int source)
+{
+    int id = _nodes.size();
+    Node node = { parent, 0, kind, source, 0, QVector<int>() };
+    _nodes.append(node);
+
+    QVector<int>& children = _nodes[parent].children;
+    if (position < 0 || position > children.size())
+        position = children.size();
+
+    children.insert(position, id);
+    for (int i = position; i < children.size(); ++i)
+        _nodes[children.at(i)].row = i;
+
+    return id;
+}
+
+int SymbolTreeModel::nodeOf(const QModelIndex& index) const
+{
+    if (!index.isValid())
+        return RootNode;
+
+    quintptr id = index.internalId();
+    return (id & s_rowFlag) ? -1 : int(id);
+}
+
+QModelIndex SymbolTreeModel::indexOf(int node) const
+{
+    if (node == RootNode)
+        return QModelIndex();
+
+    return createIndex(_nodes.at(node).row, 0, quintptr(node));
+}
+
+bool SymbolTreeModel::hasRowChildren(int node) const
+{
+    switch (_nodes.at(node).kind)
+    {
+    case Root:
+        return (_topLevel == Typedef);
+    case Typedefs:
+    case Functions:
+    case SourceFiles:
+    case Enum:
+    case UserType:
+        return true;
+    default:
+        return false;
+    }
+}
+
+int SymbolTreeModel::available(int node) const
+{
+    const Node& item = _nodes.at(node);
+
+    switch (item.kind)
+    {
+    case Root:
+        return (_topLevel == Root) ? item.children.size() : _order.size();
+    case Compiland:
+    {
+        const SymbolModule& module = _database->modules().at(item.source);
+        return int(!module.typedefs.isEmpty()) + int(!module.functions.isEmpty()) +
+               int(!module.sourceFiles.isEmpty());
+    }
+    case Typedefs:
+        return _database->modules().at(item.source).typedefs.size();
+    case Functions:
+        return _database->modules().at(item.source).functions.size();
+    case SourceFiles:
+        return _database->modules().at(item.source).sourceFiles.size();
+    case Enum:
+        return _database->enums().at(item.source).values.size();
+    case UserType:
+        return _database->userTypes().at(item.source).members.size();
+    default:
+        return item.children.size();
+    }
+}
+
+int SymbolTreeModel::shown(int node) const
+{
+    const Node& item = _nodes.at(node);
+    return hasRowChildren(node) ? item.fetched : item.children.size();
+}
+
+SymbolTreeModel::Kind SymbolTreeModel::groupAt(int module, int row) const
+{
+    const SymbolModule& item = _database->modules().at(module);
+
+    // Empty groups are not shown, so rows only count the present ones
+    if (!item.typedefs.isEmpty() && row-- == 0)
+        return Typedefs;
+    if (!item.functions.isEmpty() && row-- == 0)
+        return Functions;
+
+    return SourceFiles;
+}
+
+QVariant SymbolTreeModel::nodeData(int node, int column, int role) const
+{
+    const Node& item = _nodes.at(node);
+
+    if (role == Qt::DecorationRole)
+    {
+        if (column != 0)
+            return QVariant();
+
+        switch (item.kind)
+        {
+        case Executable:
+            return _icons.at(IconExecutable);
+        case Library:
+            return _icons.at(IconLibrary);
+        case Directory:
+            return _icons.at((item.parent == RootNode) ? IconDrive : IconFolder);
+        case Compiland:
+        {
+            const QString& name = _database->modules().at(item.source).compiland.name;
+            if (name.endsWith(".res", Qt::CaseInsensitive))
+                return _icons.at(IconResources);
+            if (name.endsWith(".dll", Qt::CaseInsensitive))
+                return _icons.at(IconDll);
+            if (name.endsWith(".obj", Qt::CaseInsensitive))
+                return _icons.at(IconModule);
+            return _icons.at(IconUnknown);
+        }
+        case Typedefs:
+            return _icons.at(IconTypedefs);
+        case Functions:
+            return _icons.at(IconFunctions);
+        case SourceFiles:
+            return _icons.at(IconSourceFiles);
+        case Enum:
+            return _icons.at(IconEnum);
+        case UserType:
+        {
+            const QString& kind = _database->userTypes().at(item.source).kind;
+            if (kind == QStringLiteral("class"))
+                return _icons.at(IconClass);
+            if (kind == QStringLiteral("struct"))
+                return _icons.at(IconStruct);
+            if (kind == QStringLiteral("union"))
+                return _icons.at(IconUnion);
+            return _icons.at(IconInterface);
+        }
+        default:
+            return QVariant();
+        }
+    }
+
+    if (role == Qt::TextAlignmentRole)
+    {
+        bool sized = item.kind == Compiland || item.kind == Executable || item.kind == Library;
+        return (sized && column >= 2) ? QVariant(int(Qt::AlignRight | Qt::AlignVCenter)) : QVariant();
+    }
+
+    // Paths are long, so they are repeated in a tooltip
+    if (role != Qt::DisplayRole && !(role == Qt::ToolTipRole && column == 1))
+        return QVariant();
+
+    switch (item.kind)
+    {
+    case Executable:
+    case Library:
+    {
+        const SymbolLibrary& library = _database->libraries().at(item.source);
+        if (column == 0)
+            return library.name;
+        if (column == 1)
+            return library.path;
+
+        const ContributionIndex::Totals& totals = _database->libraries().totals(item.source);
+        return QString::number((column == 2) ? totals.code : totals.data);
+    }
+    case Directory:
+    {
+        const Label& label = _labels.at(item.source);
+        if (column == 0)
+            return label.name;
+        return (column == 1) ? label.description : QString();
+    }
+    case Compiland:
+    {
+        const SymbolCompiland& compiland = _database->modules().at(item.source).compiland;
+        if (column == 0)
+            return fileNameOf(compiland.name);
+        if (column == 1)
+            return compiland.objectPath.isEmpty() ? compiland.name : compiland.objectPath;
+
+        ContributionIndex::Totals totals = _database->contributions().totals(compiland.id);
+        return QString::number((column == 2) ? totals.code : totals.data);
+    }
+    case Typedefs:
+        return (column == 0) ? QStringLiteral("Typedefs (%1)").arg(available(node)) : QString();
+    case Functions:
+        return (column == 0) ? QStringLiteral("Functions (%1)").arg(available(node)) : QString();
+    case SourceFiles:
+        return (column == 0) ? QStringLiteral("Source Code (%1)").arg(available(node)) : QString();
+    case Enum:
+    {
+        const SymbolEnum& symbol = _database->enums().at(item.source);
+        if (column == 0)
+            return symbol.name;
+        return (column == 1 && symbol.type != QStringLiteral("int")) ? symbol.type : QString();
+    }
+    case UserType:
+    {
+        const SymbolUserType& symbol = _database->userTypes().at(item.source);
+        if (column == 0)
+            return symbol.kind + QLatin1Char(' ') + symbol.name;
+        return (column == 1) ? symbol.type : QString();
+    }
+    default:
+        return QVariant();
+    }
+}
+
+QVariant SymbolTreeModel::rowData(int node, int row, int column, int role) const
+{
+    const Node& item = _nodes.at(node);
+
+    if (role == Qt::DecorationRole)
+    {
+        if (column != 0)
+            return QVariant();
+
+        switch (item.kind)
+        {
+        case Root:
+        case Typedefs:
+            return _icons.at(IconTypedef);
+        case Functions:
+            return _icons.at(IconFunction);
+        case SourceFiles:
+            return _icons.at(IconSourceFile);
+        default:
+            return _icons.at(IconMember);
+        }
+    }
+
+    if (role != Qt::DisplayRole)
+        return QVariant();
+
+    switch (item.kind)
+    {
+    case Root:
+    case Typedefs:
+    {
+        const SymbolTypedef& symbol = (item.kind == Root)
+            ? _database->typedefs().at(_order.at(row))
+            : _database->modules().at(item.source).typedefs.at(row);
+        if (column == 0)
+            return symbol.type;
+        return (column == 1) ? symbol.name : QString();
+    }
+    case Functions:
+        return (column == 0) ? _database->modules().at(item.source).functions.at(row).name : QString();
+    case SourceFiles:
+    {
+        const QString& path = _database->modules().at(item.source).sourceFiles.at(row).fileName;
+        if (column == 0)
+            return fileNameOf(path);
+        return (column == 1) ? path : QString();
+    }
+    case Enum:
+    {
+        const SymbolMember& value = _database->enums().at(item.source).values.at(row);
+        if (column == 0)
+            return value.name;
+        return (column == 1) ? value.value : QString();
+    }
+    case UserType:
+    {
+        const SymbolMember& member = _database->userTypes().at(item.source).members.at(row);
+        if (column == 0)
+            return member.type + QLatin1Char(' ') + member.name;
+        return (column == 1) ? member.value : QString();
+    }
+    default:
+        return QVariant();
+    }
+}
@@ -0,0 +1,140 @@
+#ifndef SYMBOLTREEMODEL_H
+#define SYMBOLTREEMODEL_H
+
+
+#include <QAbstractItemModel>
+#include <QIcon>
+#include <QStringList>
+#include <QVector>
+
+class SymbolDatabase;
+
+
+// Tree over the records of a SymbolDatabase. Only libraries, directories and
+// compilands are built up front, everything below them is created when the
+// view first expands a node: module groups and enums or user types become
+// nodes, typedefs, functions, source files and members are never more than
+// a row number into the database.
+class SymbolTreeModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    enum Kind
+    {
+        Root,
+        Executable,
+        Library,
+        Directory,
+        Compiland,
+        Typedefs,
+        Functions,
+        SourceFiles,
+        Typedef,
+        Enum,
+        UserType
+    };
+
+    enum { RootNode = 0, FetchBatch = 1024 };
+
+public:
+    SymbolTreeModel(const SymbolDatabase* database, const QStringList& header, QObject* parent = nullptr);
+
+    void clear();
+
+    // Structure added between beginBuild() and endBuild() is shown in one reset,
+    // outside of them every added node is inserted into the view on its own
+    void beginBuild();
+    void endBuild();
+
+    int addGroup(int parent, int position, Kind kind, const QString& name,
+                 const QString& description = QString());
+    // Top level row of a library from the database's library index
+    int addLibrary(int library);
+    int addCompiland(int parent, int module);
+    // Top level rows taken from the database's typedefs, enums or user types in the given order
+    void setTopLevel(Kind kind, const QVector<int>& order);
+
+    int childCount(int node) const;
+    int child(int node, int row) const;
+    QString name(int node) const;
+
+    QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex& index) const override;
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    bool hasChildren(const QModelIndex& parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    enum Icon
+    {
+        IconExecutable,
+        IconLibrary,
+        IconDrive,
+        IconFolder,
+        IconModule,
+        IconResources,
+        IconDll,
+        IconUnknown,
+        IconTypedefs,
+        IconFunctions,
+        IconSourceFiles,
+        IconTypedef,
+        IconFunction,
+        IconSourceFile,
+        IconEnum,
+        IconMember,
+        IconClass,
+        IconStruct,
+        IconUnion,
+        IconInterface,
+        IconCount
+    };
+
+    struct Node
+    {
+        int parent;
+        int row;
+        Kind kind;
+        // Library, module, enum or user type index, or the label of a group
+        int source;
+        // Rows shown so far when the children are plain rows
+        int fetched;
+        QVector<int> children;
+    };
+
+    struct Label
+    {
+        QString name;
+        QString description;
+    };
+
+    int insertNode(int parent, int position, Kind kind, int source);
+    int addNode(int parent, int position, Kind kind, int source);
+    int nodeOf(const QModelIndex& index) const;
+    QModelIndex indexOf(int node) const;
+    bool hasRowChildren(int node) const;
+    int available(int node) const;
+    int shown(int node) const;
+    Kind groupAt(int module, int row) const;
+
+    QVariant nodeData(int node, int column, int role) const;
+    QVariant rowData(int node, int row, int column, int role) const;
+
+private:
+    const SymbolDatabase* _database;
+    QStringList _header;
+    QVector<QIcon> _icons;
+    QVector<Node> _nodes;
+    QVector<Label> _labels;
+    Kind _topLevel;
+    QVector<int> _order;
+    bool _building;
+};
+
+
+#endif // SYMBOLTREEMODEL_H
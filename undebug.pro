@@ -2,15 +2,69 @@ QT += widgets
 
 INCLUDEPATH += $${PWD}/include
 
-HEADERS       = mainwindow.h \
+HEADERS       = addressmap.h \
+                addressresolver.h \
+                atomtable.h \
+                codeview.h \
+                contributionindex.h \
+                cvsymbols.h \
+                directorytrie.h \
+                fakesymbolprovider.h \
+                libraryindex.h \
+                mainwindow.h \
                 mdichild.h \
+                msf.h \
+                nativesymbolprovider.h \
                 path.h \
-                qdia.h
-SOURCES       = main.cpp \
+                pdbdbi.h \
+                pdbfile.h \
+                pdbgsi.h \
+                pdblines.h \
+                pdbnames.h \
+                pdbtpi.h \
+                pefile.h \
+                symboldatabase.h \
+                symbolfilter.h \
+                symbolloader.h \
+                symbolorder.h \
+                symbolprovider.h \
+                symbolstore.h \
+                symboltreemodel.h
+SOURCES       = addressmap.cpp \
+                addressresolver.cpp \
+                atomtable.cpp \
+                contributionindex.cpp \
+                cvsymbols.cpp \
+                directorytrie.cpp \
+                fakesymbolprovider.cpp \
+                libraryindex.cpp \
+                main.cpp \
                 mainwindow.cpp \
                 mdichild.cpp \
+                msf.cpp \
+                nativesymbolprovider.cpp \
                 path.cpp \
-                qdia.cpp
+                pdbdbi.cpp \
+                pdbfile.cpp \
+                pdbgsi.cpp \
+                pdblines.cpp \
+                pdbnames.cpp \
+                pdbtpi.cpp \
+                pefile.cpp \
+                symboldatabase.cpp \
+                symbolfilter.cpp \
+                symbolloader.cpp \
+                symbolorder.cpp \
+                symbolprovider.cpp \
+                symbolstore.cpp \
+                symboltreemodel.cpp
 RESOURCES     = undebug.qrc
 
-LIBS += OleAut32.lib
+win32 {
+    HEADERS += diasymbolprovider.h \
+               qdia.h
+    SOURCES += diasymbolprovider.cpp \
+               qdia.cpp
+
+    LIBS += OleAut32.lib
+}